@@ -0,0 +1,342 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "fake_proc.h"
+#include "linux_parser.h"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::string_view;
+
+// Seconds the fake machine was up before the first tick, and its clock
+// ticks per second.
+static const long kUptime{864000};
+static const long kHertz{100};
+
+// PF_KTHREAD and the flags a user space process usually carries.
+static const long kKernelThreadFlags{0x00208040};
+static const long kUserFlags{0x00400100};
+
+struct Program {
+  const char* name;     // comm, as in stat and status
+  const char* cmdline;  // arguments separated by spaces
+  int uid;
+  long vm_size;         // KiB
+};
+
+static const Program kPrograms[] = {
+    {"systemd", "/lib/systemd/systemd --user", 1000, 21504},
+    {"bash", "-bash", 1000, 10112},
+    {"sshd", "sshd: deploy@pts/0", 0, 17676},
+    {"nginx", "nginx: worker process", 33, 58144},
+    {"java",
+     "/usr/lib/jvm/java-17-openjdk-amd64/bin/java -Xms2g -Xmx4g "
+     "-XX:+UseG1GC -jar /opt/orders/orders-service.jar "
+     "--spring.profiles.active=production",
+     1001, 7340032},
+    {"python3", "/usr/bin/python3 /opt/jobs/worker.py --queue default -c 4",
+     1001, 412160},
+    {"postgres", "postgres: 14/main: app orders 10.0.3.17(51234) idle", 999,
+     221184},
+    {"node", "node /srv/gateway/dist/server.js --port 8080", 1001, 1123328},
+    {"containerd-shim",
+     "/usr/bin/containerd-shim-runc-v2 -namespace moby -id "
+     "4f5e0c2a9d1b7e36a8c4f09d2b6e1a3c5d7f9e0b2c4a6e8d0f1b3c5a7e9d2f4b "
+     "-address /run/containerd/containerd.sock",
+     0, 722944},
+    {"cron", "/usr/sbin/cron -f", 0, 6688},
+};
+
+static const char* const kKernelThreads[] = {"kworker/%d:1H", "ksoftirqd/%d",
+                                             "migration/%d", "rcu_preempt"};
+
+static const char kPasswd[] =
+    "root:x:0:0:root:/root:/bin/bash\n"
+    "daemon:x:1:1:daemon:/usr/sbin:/usr/sbin/nologin\n"
+    "www-data:x:33:33:www-data:/var/www:/usr/sbin/nologin\n"
+    "postgres:x:999:999:PostgreSQL administrator:/var/lib/postgresql:"
+    "/bin/bash\n"
+    "deploy:x:1000:1000:Deploy,,,:/home/deploy:/bin/bash\n"
+    "app:x:1001:1001::/srv/app:/usr/sbin/nologin\n";
+
+static const char kOSRelease[] =
+    "PRETTY_NAME=\"Debian GNU/Linux 12 (bookworm)\"\n"
+    "NAME=\"Debian GNU/Linux\"\n"
+    "VERSION_ID=\"12\"\n"
+    "VERSION=\"12 (bookworm)\"\n"
+    "ID=debian\n";
+
+static const char kVersion[] =
+    "Linux version 6.1.0-18-amd64 (debian-kernel@lists.debian.org) "
+    "(gcc-12 (Debian 12.2.0-14) 12.2.0, GNU ld (GNU Binutils for Debian) "
+    "2.40) #1 SMP PREEMPT_DYNAMIC Debian 6.1.76-1 (2024-02-01)\n";
+
+static void Write(const string& path, string_view text) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  while (!text.empty()) {
+    ssize_t written = write(fd, text.data(), text.size());
+    if (written <= 0) {
+      break;
+    }
+    text.remove_prefix(written);
+  }
+  close(fd);
+}
+
+FakeProc::FakeProc(string root, int processes, int cores)
+    : root_(std::move(root)), cores_(cores), random_(42) {
+  fs::create_directories(root_ + LinuxParser::kProcDirectory);
+  fs::create_directories(root_ + LinuxParser::kProcDirectory + "/net");
+  fs::create_directories(fs::path(root_ + LinuxParser::kOSPath).parent_path());
+  // Pids grow with small gaps, as they do once processes come and go.
+  int pid{1};
+  for (int i = 0; i < processes; ++i) {
+    pids_.push_back(pid);
+    pid += 1 + random_() % 4;
+  }
+  for (int each : pids_) {
+    WriteProcess(each);
+  }
+  WriteSystem();
+}
+
+// Advance the clock by a second. One process in ten, a different tenth
+// every tick, used some CPU time since.
+void FakeProc::Tick() {
+  ++tick_;
+  for (size_t i = tick_ % 10; i < tasks_.size(); i += 10) {
+    Task& task = tasks_[i];
+    task.utime += random_() % 100;
+    task.stime += random_() % 20;
+    WriteStat(task);
+    WriteIo(task);
+  }
+  WriteSystem();
+}
+
+FakeProc::~FakeProc() {
+  std::error_code error;
+  fs::remove_all(root_, error);
+}
+
+const string& FakeProc::Root() const { return root_; }
+
+const std::vector<int>& FakeProc::Pids() const { return pids_; }
+
+void FakeProc::WriteSystem() {
+  using namespace LinuxParser;
+  const string proc = root_ + kProcDirectory;
+  string stat;
+  char line[256];
+  long idle_total{0};
+  for (int core = -1; core < cores_; ++core) {
+    // Each tick is one second: 60 busy and 40 idle ticks per core.
+    long user = 50000 + core * 1000 + tick_ * 60;
+    long idle = 700000 + core * 3000 + tick_ * 40;
+    idle_total += core < 0 ? 0 : idle;
+    string name = core < 0 ? "cpu " : "cpu" + std::to_string(core);
+    if (core < 0) {
+      user *= cores_;
+      idle *= cores_;
+    }
+    snprintf(line, sizeof(line), "%s %ld %ld %ld %ld %ld 0 %ld %ld 0 0\n",
+             name.c_str(), user, user / 20, user / 3, idle, idle / 100,
+             user / 50, user / 200);
+    stat += line;
+  }
+  snprintf(line, sizeof(line),
+           "intr 123456789 0 9 0 0 0 0 0 0 1 0 0 0 156 0 0 0\n"
+           "ctxt 987654321\nbtime 1700000000\nprocesses %zu\n"
+           "procs_running %d\nprocs_blocked 0\n",
+           pids_.size() * 3, cores_ / 2 + 1);
+  stat += line;
+  stat += "softirq 45678901 0 1234567 89 2345678 0 0 345678 3456789 0 456\n";
+  Write(proc + kStatFilename, stat);
+
+  Write(proc + kMeminfoFilename,
+        "MemTotal:       65841228 kB\n"
+        "MemFree:        21234512 kB\n"
+        "MemAvailable:   48123456 kB\n"
+        "Buffers:          912344 kB\n"
+        "Cached:         24567812 kB\n"
+        "SwapCached:            0 kB\n"
+        "Active:         18234560 kB\n"
+        "Inactive:       21345672 kB\n"
+        "SwapTotal:       8388604 kB\n"
+        "SwapFree:        8388604 kB\n"
+        "Dirty:              1424 kB\n"
+        "AnonPages:      14123456 kB\n"
+        "Mapped:          1234568 kB\n"
+        "Shmem:            345672 kB\n"
+        "Slab:            2345676 kB\n"
+        "PageTables:       123456 kB\n"
+        "CommitLimit:    41309216 kB\n"
+        "Committed_AS:   32123456 kB\n"
+        "VmallocTotal:   34359738367 kB\n"
+        "HugePages_Total:       0\n"
+        "Hugepagesize:       2048 kB\n");
+  snprintf(line, sizeof(line), "%ld.42 %ld.17\n", kUptime + tick_,
+           idle_total / kHertz);
+  Write(proc + kUptimeFilename, line);
+
+  // A busy disk with one partition, and a loop device the monitor skips.
+  char diskstats[512];
+  long reads = 1200000 + tick_ * 150;
+  long writes = 3400000 + tick_ * 420;
+  long io_ms = 4500000 + tick_ * 380;
+  snprintf(diskstats, sizeof(diskstats),
+           " 253       0 vda %ld 3456 %ld %ld %ld 98765 %ld %ld 0 %ld %ld\n"
+           " 253       1 vda1 %ld 3456 %ld %ld %ld 98765 %ld %ld 0 %ld %ld\n"
+           "   7       0 loop0 512 0 4096 37 0 0 0 0 0 40 37\n",
+           reads, reads * 24, reads / 2, writes, writes * 16, writes * 3,
+           io_ms, reads / 2 + writes * 3, reads, reads * 24, reads / 2,
+           writes, writes * 16, writes * 3, io_ms, reads / 2 + writes * 3);
+  Write(proc + kDiskstatsFilename, diskstats);
+
+  // A loopback and one busy interface, which drops a packet now and then.
+  char dev[768];
+  long received = 9876543210 + tick_ * 12500000;
+  long sent = 1234567890 + tick_ * 3400000;
+  snprintf(dev, sizeof(dev),
+           "Inter-|   Receive                                                "
+           "|  Transmit\n"
+           " face |bytes    packets errs drop fifo frame compressed multicast"
+           "|bytes    packets errs drop fifo colls carrier compressed\n"
+           "    lo: 45678901  123456    0    0    0     0          0         "
+           "0 45678901  123456    0    0    0     0       0          0\n"
+           "  eth0:%ld %ld    0 %ld    0     0          0      1234 %ld %ld"
+           "    0    0    0     0       0          0\n",
+           received, received / 1400, tick_ / 7, sent, sent / 900);
+  Write(proc + kNetDevFilename, dev);
+  char snmp[512];
+  snprintf(snmp, sizeof(snmp),
+           "Tcp: RtoAlgorithm RtoMin RtoMax MaxConn ActiveOpens PassiveOpens "
+           "AttemptFails EstabResets CurrEstab InSegs OutSegs RetransSegs "
+           "InErrs OutRsts InCsumErrors\n"
+           "Tcp: 1 200 120000 -1 4567 8901 12 34 56 %ld %ld %ld 0 789 0\n",
+           9000000 + tick_ * 8000, 7000000 + tick_ * 6000,
+           2100 + tick_ * 3);
+  Write(proc + kSnmpFilename, snmp);
+  if (tick_ > 0) {
+    return;
+  }
+  Write(proc + kVersionFilename, kVersion);
+  Write(root_ + kOSPath, kOSRelease);
+  Write(root_ + kPasswordPath, kPasswd);
+}
+
+void FakeProc::WriteStat(const Task& task) {
+  using namespace LinuxParser;
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s%s%d%s", root_.c_str(),
+           kProcDirectory.c_str(), task.pid, kStatFilename.c_str());
+  long rss = task.vm_size / 4;
+  char stat[512];
+  snprintf(stat, sizeof(stat),
+           "%d (%s) %c %d %d %d 0 -1 %ld %ld 0 %ld 0 %ld %ld %ld %ld 20 0 %d "
+           "0 %ld %ld %ld 18446744073709551615 94012345678848 "
+           "94012345923456 140723456789504 0 0 0 0 4096 16387 0 0 0 17 %d 0 "
+           "0 0 0 0 94012346012345 94012346034567 94012367891234 "
+           "140723456790123 140723456790234 140723456790234 140723456794567 "
+           "0\n",
+           task.pid, task.comm.c_str(), task.state, task.kernel ? 2 : 1,
+           task.pid, task.pid, task.kernel ? kKernelThreadFlags : kUserFlags,
+           task.utime * 3, task.utime / 100, task.utime, task.stime,
+           task.utime / 10, task.stime / 10, task.threads, task.starttime,
+           task.vm_size * 1024, rss / 4, task.processor);
+  Write(path, stat);
+}
+
+// Bytes read and written follow the CPU time used.
+void FakeProc::WriteIo(const Task& task) {
+  using namespace LinuxParser;
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s%s%d%s", root_.c_str(),
+           kProcDirectory.c_str(), task.pid, kIoFilename.c_str());
+  char io[256];
+  snprintf(io, sizeof(io),
+           "rchar: %ld\nwchar: %ld\nsyscr: %ld\nsyscw: %ld\n"
+           "read_bytes: %ld\nwrite_bytes: %ld\ncancelled_write_bytes: 0\n",
+           task.utime * 9000, task.stime * 7000, task.utime * 3,
+           task.stime * 2, task.utime * 4096, task.stime * 4096);
+  Write(path, io);
+}
+
+void FakeProc::WriteProcess(int pid) {
+  using namespace LinuxParser;
+  const string directory = root_ + kProcDirectory + std::to_string(pid);
+  fs::create_directory(directory);
+
+  // One in twenty is a kernel thread, one in five hundred a zombie.
+  Task task;
+  task.pid = pid;
+  task.kernel = random_() % 20 == 0;
+  task.state = random_() % 500 == 0 ? 'Z' : random_() % 10 == 0 ? 'R' : 'S';
+  const Program& program = kPrograms[random_() % std::size(kPrograms)];
+  char name[32];
+  snprintf(name, sizeof(name),
+           kKernelThreads[random_() % std::size(kKernelThreads)],
+           static_cast<int>(random_() % cores_));
+  task.comm = task.kernel ? name : program.name;
+  int uid = task.kernel ? 0 : program.uid;
+  task.vm_size = task.kernel ? 0 : program.vm_size + random_() % 4096;
+  task.utime = random_() % 200000;
+  task.stime = task.utime / 4 + random_() % 1000;
+  task.starttime = random_() % (kUptime * kHertz);
+  task.threads = task.kernel ? 1 : 1 + random_() % 32;
+  task.processor = random_() % cores_;
+  tasks_.push_back(task);
+  WriteStat(task);
+  WriteIo(task);
+
+  long vm_size = task.vm_size;
+  long rss = vm_size / 4;
+  char status[2048];
+  snprintf(status, sizeof(status),
+           "Name:\t%s\nUmask:\t0022\nState:\t%c (%s)\nTgid:\t%d\nNgid:\t0\n"
+           "Pid:\t%d\nPPid:\t1\nTracerPid:\t0\nUid:\t%d\t%d\t%d\t%d\n"
+           "Gid:\t%d\t%d\t%d\t%d\nFDSize:\t64\nGroups:\t%d \nNStgid:\t%d\n"
+           "NSpid:\t%d\nNSpgid:\t%d\nNSsid:\t%d\n"
+           "VmPeak:\t%8ld kB\nVmSize:\t%8ld kB\nVmLck:\t       0 kB\n"
+           "VmPin:\t       0 kB\nVmHWM:\t%8ld kB\nVmRSS:\t%8ld kB\n"
+           "RssAnon:\t%8ld kB\nRssFile:\t%8ld kB\nRssShmem:\t       0 kB\n"
+           "VmData:\t%8ld kB\nVmStk:\t     132 kB\nVmExe:\t     884 kB\n"
+           "VmLib:\t    4512 kB\nVmPTE:\t     120 kB\nVmSwap:\t       0 kB\n"
+           "HugetlbPages:\t       0 kB\nCoreDumping:\t0\nTHP_enabled:\t1\n"
+           "Threads:\t%d\nSigQ:\t0/257326\nSigPnd:\t0000000000000000\n"
+           "ShdPnd:\t0000000000000000\nSigBlk:\t0000000000000000\n"
+           "SigIgn:\t0000000000001000\nSigCgt:\t0000000180004a02\n"
+           "CapInh:\t0000000000000000\nCapPrm:\t0000000000000000\n"
+           "CapEff:\t0000000000000000\nCapBnd:\t000001ffffffffff\n"
+           "CapAmb:\t0000000000000000\nNoNewPrivs:\t0\nSeccomp:\t0\n"
+           "Seccomp_filters:\t0\nSpeculation_Store_Bypass:\tthread vulnerable\n"
+           "SpeculationIndirectBranch:\tconditional enabled\n"
+           "Cpus_allowed:\tff\nCpus_allowed_list:\t0-%d\n"
+           "Mems_allowed:\t00000000,00000001\nMems_allowed_list:\t0\n"
+           "voluntary_ctxt_switches:\t%ld\nnonvoluntary_ctxt_switches:\t%ld\n",
+           task.comm.c_str(), task.state,
+           task.state == 'Z' ? "zombie" : "sleeping", pid, pid, uid, uid, uid,
+           uid, uid, uid, uid, uid, uid, pid, pid, pid, pid, vm_size + 512,
+           vm_size, rss + 64, rss, rss * 3 / 4, rss / 4, vm_size / 2,
+           task.threads, cores_ - 1, task.utime * 7, task.stime / 3);
+  Write(directory + kStatusFilename, status);
+
+  string cmdline = task.kernel ? "" : program.cmdline;
+  for (char& c : cmdline) {
+    if (c == ' ') {
+      c = '\0';
+    }
+  }
+  if (!cmdline.empty()) {
+    cmdline += '\0';
+  }
+  Write(directory + kCmdlineFilename, cmdline);
+}
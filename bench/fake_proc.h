@@ -0,0 +1,58 @@
+#ifndef FAKE_PROC_H
+#define FAKE_PROC_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * FakeProc class
+ * Writes a synthetic root for LinuxParser::SetRoot():
+ * proc/{stat,meminfo,uptime,version}, etc/{os-release,passwd} and
+ * proc/<pid>/{stat,status,cmdline} for the requested number of processes.
+ * The files follow the layout of a current kernel. Processes are a mix of
+ * services, shells, workers and kernel threads with a few zombies. A fixed
+ * seed gives every run the same tree. Tick() moves the clock on by a
+ * second and charges CPU time to a tenth of the processes. The tree is
+ * removed on destruction.
+ */
+class FakeProc {
+ public:
+  FakeProc(std::string root, int processes, int cores = 8);
+  ~FakeProc();
+  FakeProc(const FakeProc&) = delete;
+  FakeProc& operator=(const FakeProc&) = delete;
+
+  void Tick();
+  const std::string& Root() const;
+  const std::vector<int>& Pids() const;
+
+ private:
+  // What /proc/<pid>/stat shows of a process.
+  struct Task {
+    int pid{0};
+    std::string comm;
+    char state{'S'};
+    bool kernel{false};
+    long utime{0};
+    long stime{0};
+    long starttime{0};
+    long vm_size{0};  // KiB
+    int threads{1};
+    int processor{0};
+  };
+
+  void WriteSystem();
+  void WriteProcess(int pid);
+  void WriteStat(const Task& task);
+  void WriteIo(const Task& task);
+
+  std::string root_;
+  int cores_;
+  long tick_{0};
+  std::vector<int> pids_;
+  std::vector<Task> tasks_;
+  std::mt19937 random_;
+};
+
+#endif
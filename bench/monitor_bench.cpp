@@ -0,0 +1,604 @@
+#include <curses.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "collector.h"
+#include "exporter.h"
+#include "fake_proc.h"
+#include "fd_cache.h"
+#include "frame.h"
+#include "history.h"
+#include "linux_parser.h"
+#include "metrics_log.h"
+#include "ncurses_display.h"
+#include "proc_reader.h"
+#include "process_table.h"
+#include "system.h"
+#include "system_snapshot.h"
+
+using std::string;
+using std::vector;
+
+// Every allocation made through operator new, by any thread.
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+// Results are kept out of the optimizer's reach here.
+static volatile long sink;
+
+// Elapsed time, syscalls and allocations of one measured run.
+struct Sample {
+  double ns{0};
+  double syscalls{0};
+  double allocations{0};
+};
+
+// Rounds of a measurement; the lowest value of each metric counts, which
+// keeps noise from other work on the machine out of the result.
+static const int kRounds{5};
+
+template <typename Body>
+static Sample Measure(int repeats, Body body) {
+  using Clock = std::chrono::steady_clock;
+  Sample best;
+  for (int round = 0; round < kRounds; ++round) {
+    long syscalls = ProcReader::Syscalls();
+    long allocated = allocations.load();
+    auto start = Clock::now();
+    for (int repeat = 0; repeat < repeats; ++repeat) {
+      body();
+    }
+    Sample sample;
+    sample.ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    sample.syscalls = ProcReader::Syscalls() - syscalls;
+    sample.allocations = allocations.load() - allocated;
+    if (round == 0) {
+      best = sample;
+    }
+    best.ns = std::min(best.ns, sample.ns);
+    best.syscalls = std::min(best.syscalls, sample.syscalls);
+    best.allocations = std::min(best.allocations, sample.allocations);
+  }
+  return best;
+}
+
+struct Result {
+  string name;
+  string metric;
+  double value;
+};
+
+static vector<Result> results;
+
+static void Report(const string& name, const string& metric, double value) {
+  results.push_back({name, metric, value});
+  printf("%-28s %-18s %14.2f\n", name.c_str(), metric.c_str(), value);
+}
+
+// Report a sample as ns, syscalls and allocations per unit.
+static void Report(const string& name, const string& unit, Sample sample,
+                   double units) {
+  Report(name, "ns/" + unit, sample.ns / units);
+  Report(name, "syscalls/" + unit, sample.syscalls / units);
+  Report(name, "allocs/" + unit, sample.allocations / units);
+}
+
+static string Name(const string& benchmark, size_t processes) {
+  return benchmark + "/" + std::to_string(processes);
+}
+
+// Results named .../live measure whatever the host runs, so they are
+// shown but neither kept as baselines nor compared against them.
+static bool Live(const Result& result) {
+  const string suffix{"/live"};
+  return result.name.size() >= suffix.size() &&
+         result.name.compare(result.name.size() - suffix.size(),
+                             suffix.size(), suffix) == 0;
+}
+
+// Each LinuxParser function that reads one process, over every pid.
+static void BenchProcessParsers(const vector<int>& pids) {
+  const int repeats = std::max<int>(1, 50000 / pids.size());
+  const double calls = static_cast<double>(pids.size()) * repeats;
+  auto bench = [&](const char* name, auto function) {
+    for (int pid : pids) {
+      function(pid);  // warm the fd and user caches
+    }
+    Sample sample = Measure(repeats, [&] {
+      for (int pid : pids) {
+        function(pid);
+      }
+    });
+    Report(Name(name, pids.size()), "call", sample, calls);
+  };
+  bench("Stat", [](int pid) {
+    LinuxParser::ProcessStat stat;
+    sink = LinuxParser::Stat(pid, stat);
+  });
+  bench("Status", [](int pid) {
+    LinuxParser::ProcessStatus status;
+    sink = LinuxParser::Status(pid, ~0u, status);
+  });
+  bench("Command", [](int pid) { sink = LinuxParser::Command(pid).size(); });
+  bench("Ram", [](int pid) { sink = LinuxParser::Ram(pid); });
+  bench("Uid", [](int pid) { sink = LinuxParser::Uid(pid).size(); });
+  bench("User", [](int pid) { sink = LinuxParser::User(pid).size(); });
+  bench("UpTimePid", [](int pid) { sink = LinuxParser::UpTime(pid); });
+  bench("CpuUtilizationPid",
+        [](int pid) { sink = LinuxParser::CpuUtilization(pid) * 100; });
+  bench("ActiveJiffiesPid",
+        [](int pid) { sink = LinuxParser::ActiveJiffies(pid); });
+  for (int pid : pids) {
+    LinuxParser::Release(pid);
+  }
+}
+
+// Each LinuxParser function that reads the machine as a whole.
+static void BenchSystemParsers(size_t processes) {
+  const int repeats{500};
+  auto bench = [&](const char* name, auto function) {
+    function();
+    Report(Name(name, processes), "call", Measure(repeats, function),
+           repeats);
+  };
+  vector<int> pids;
+  bench("Pids", [&] { LinuxParser::Pids(pids, true); });
+  bench("MemoryUtilization",
+        [] { sink = LinuxParser::MemoryUtilization() * 100; });
+  bench("UpTime", [] { sink = LinuxParser::UpTime(); });
+  bench("TotalProcesses", [] { sink = LinuxParser::TotalProcesses(); });
+  bench("RunningProcesses", [] { sink = LinuxParser::RunningProcesses(); });
+  bench("OperatingSystem",
+        [] { sink = LinuxParser::OperatingSystem().size(); });
+  bench("Kernel", [] { sink = LinuxParser::Kernel().size(); });
+  bench("CpuUtilization",
+        [] { sink = LinuxParser::CpuUtilization() * 100; });
+  bench("Jiffies", [] { sink = LinuxParser::Jiffies(); });
+  bench("ActiveJiffies", [] { sink = LinuxParser::ActiveJiffies(); });
+  bench("IdleJiffies", [] { sink = LinuxParser::IdleJiffies(); });
+  bench("Snapshot", [] {
+    static SystemSnapshot snapshot;
+    snapshot.Refresh();
+  });
+}
+
+// Re-reading stat through kept descriptors against opening it each time.
+static void BenchFdCache(const vector<int>& pids) {
+  const int repeats = std::max<int>(1, 50000 / pids.size());
+  const double calls = static_cast<double>(pids.size()) * repeats;
+  Sample sample = Measure(repeats, [&] {
+    for (int pid : pids) {
+      sink = ProcReader::ReadPid(pid, "/stat").size();
+    }
+  });
+  Report(Name("OpenPerRead", pids.size()), "call", sample, calls);
+  FdCache cache;
+  for (int pid : pids) {
+    cache.Read(pid, FdCache::kStat);
+  }
+  sample = Measure(repeats, [&] {
+    for (int pid : pids) {
+      sink = cache.Read(pid, FdCache::kStat).size();
+    }
+  });
+  Report(Name("FdCacheRead", pids.size()), "call", sample, calls);
+}
+
+// One tick of the monitor: System::Processes(), Top(), the frame handed
+// to the display and the drawing.
+static void BenchSystem(FakeProc& fake, size_t processes, int threads) {
+  System system(threads);
+  system.Processes();  // the first tick fills the table
+  const int ticks = std::clamp<int>(50000 / processes, 1, 10);
+  Sample sample = Measure(ticks, [&] {
+    system.Refresh();
+    sink = system.Processes().size();
+  });
+  Report(Name("Processes", processes), "ns/process",
+         sample.ns / ticks / processes);
+  Report(Name("Processes", processes), "syscalls/tick",
+         sample.syscalls / ticks);
+  Report(Name("Processes", processes), "allocs/tick",
+         sample.allocations / ticks);
+
+  const int repeats{50};
+  system.Top(10);
+  Report(Name("Top10", processes), "call",
+         Measure(repeats, [&] { sink = system.Top(10).size(); }), repeats);
+
+  // What the sampler adds to a tick: recording it into the history, and
+  // the range queries of a frame, each over a minute of one-second ticks.
+  History history(16 << 20);
+  auto now = std::chrono::system_clock::now();
+  auto record = [&] {
+    now += std::chrono::seconds(1);
+    history.Record(now, system);
+  };
+  Report(Name("HistoryRecord", processes), "tick", Measure(repeats, record),
+         repeats);
+  const Process& busiest = system.Top(1, ProcessTable::kCpu)[0];
+  int pid = busiest.Pid();
+  long starttime = busiest.StartTime();
+  auto query = [&] {
+    sink = history.Range(History::kCpu, Frame::kSpan).samples +
+           history.Range(pid, starttime, Frame::kSpan).samples;
+  };
+  Report(Name("HistoryRange", processes), "query", Measure(repeats, query),
+         2 * repeats);
+
+  // Format every process, as --export does, into /dev/null. Collection
+  // is measured above; this repeats the same sample.
+  int null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  const vector<Process>& collected = system.Processes();
+  for (auto format : {Exporter::kJson, Exporter::kCsv}) {
+    Exporter exporter(null, format);
+    auto time = std::chrono::system_clock::now();
+    auto write = [&] { exporter.Write(time, system, collected); };
+    write();
+    Report(Name(format == Exporter::kJson ? "ExportJson" : "ExportCsv",
+                processes),
+           "sample", Measure(10, write), 10);
+  }
+  close(null);
+
+  // Copy what the screen shows out of System, as the sampler does.
+  Frame frames[2];
+  auto capture = [&] { frames[0].Capture(system, history, 10); };
+  capture();
+  Report(Name("Capture", processes), "frame", Measure(repeats, capture),
+         repeats);
+  // A second frame a tick later, so that drawing alternates between two
+  // frames that differ the way consecutive ticks do.
+  fake.Tick();
+  system.Refresh();
+  system.Processes();
+  record();
+  frames[1].Capture(system, history, 10);
+
+  // Draw into a terminal that writes to a scratch file, whose size is
+  // what a terminal would have been sent.
+  FILE* out = tmpfile();
+  FILE* in = fopen("/dev/null", "r");
+  SCREEN* screen = out && in ? newterm("xterm", out, in) : nullptr;
+  if (screen != nullptr) {
+    WINDOW* system_window = newwin(13, 79, 0, 0);
+    WINDOW* process_window = newwin(13, 79, 13, 0);
+    int drawn{0};
+    auto frame = [&] {
+      const Frame& next = frames[drawn++ % 2];
+      NCursesDisplay::DisplaySystem(next, system_window);
+      NCursesDisplay::DisplayProcesses(next, process_window, 10);
+      wnoutrefresh(system_window);
+      wnoutrefresh(process_window);
+      doupdate();
+    };
+    frame();
+    fflush(out);
+    struct stat before;
+    fstat(fileno(out), &before);
+    Report(Name("Render", processes), "frame", Measure(repeats, frame),
+           repeats);
+    fflush(out);
+    struct stat after;
+    fstat(fileno(out), &after);
+    Report(Name("Render", processes), "bytes/frame",
+           (double)(after.st_size - before.st_size) / (repeats * kRounds));
+    delwin(system_window);
+    delwin(process_window);
+    endwin();
+    delscreen(screen);
+  } else {
+    fprintf(stderr, "no xterm terminfo, skipping Render\n");
+  }
+  if (out != nullptr) {
+    fclose(out);
+  }
+  if (in != nullptr) {
+    fclose(in);
+  }
+}
+
+// A keyframe and then a minute of ticks appended to a metrics log, and
+// read back the way the log view steps through them.
+static void BenchMetricsLog(FakeProc& fake, size_t processes, int threads) {
+  System system(threads);
+  system.Processes();
+  const string directory = fake.Root() + "/log";
+  mkdir(directory.c_str(), 0755);
+  MetricsLog::Writer writer(directory, 64 << 20);
+  auto time = std::chrono::system_clock::now();
+  // Every tick differs from the one before, so each is written once and
+  // timed on its own rather than by Measure().
+  Sample sample;
+  const int ticks{MetricsLog::kKeyframe};
+  for (int tick = 0; tick < ticks; ++tick) {
+    fake.Tick();
+    system.Refresh();
+    const vector<Process>& collected = system.Processes();
+    // Read what is written beforehand, as a scan for the log would.
+    for (const Process& process : collected) {
+      sink = process.Ram() + process.User().size() + process.Command().size();
+    }
+    time += std::chrono::seconds(1);
+    long allocated = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    if (!writer.Write(time, system, collected)) {
+      fprintf(stderr, "could not write to %s\n", directory.c_str());
+    }
+    sample.ns += std::chrono::duration<double, std::nano>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    sample.allocations += allocations.load() - allocated;
+  }
+  Report(Name("LogWrite", processes), "ns/tick", sample.ns / ticks);
+  Report(Name("LogWrite", processes), "allocs/tick",
+         sample.allocations / ticks);
+  Report(Name("LogWrite", processes), "bytes/process",
+         (double)writer.Bytes() / ticks / processes);
+
+  MetricsLog::Reader reader(directory);
+  Frame frame;
+  size_t tick{0};
+  auto step = [&] {
+    sink = reader.Read(tick, ProcessTable::kCpu, 10, frame);
+    tick = (tick + 1) % reader.Ticks();
+  };
+  step();
+  Report(Name("LogRead", processes), "tick", Measure(reader.Ticks(), step),
+         reader.Ticks());
+}
+
+// Ranking an in-memory table, without any file behind it.
+static void BenchRank(size_t processes) {
+  std::mt19937 random(7);
+  SystemSnapshot snapshot;
+  snapshot.cores.resize(8);
+  snapshot.uptime_ticks = 86400000;
+  ProcessTable table;
+  for (size_t i = 0; i < processes; ++i) {
+    LinuxParser::ProcessStat stat;
+    stat.state = 'S';
+    stat.utime = random() % 200000;
+    stat.stime = random() % 50000;
+    stat.starttime = random() % snapshot.uptime_ticks;
+    uint32_t row = table.Insert(i + 1, stat.starttime);
+    table.Update(row, stat, snapshot, 1);
+  }
+  vector<uint32_t> rows;
+  const int repeats = std::max<int>(1, 500000 / processes);
+  Sample sample = Measure(repeats, [&] {
+    table.Rank(ProcessTable::kCpu, 10, 1, rows);
+    sink = rows.size();
+  });
+  Report(Name("Rank10", processes), "call", sample, repeats);
+}
+
+// Each collector over the live /proc: taskstats cannot be faked with
+// files. The process count is whatever runs on the machine, so these are
+// per process.
+static void BenchCollectors(int threads) {
+  vector<int> pids;
+  LinuxParser::Pids(pids, true);
+  vector<LinuxParser::ProcessStat> stats(pids.size());
+  const int repeats = std::max<int>(1, 50000 / pids.size());
+  const double calls = static_cast<double>(pids.size()) * repeats;
+  const std::pair<Collector::Kind, const char*> kinds[] = {
+      {Collector::kProcfs, "CollectProcfs"},
+      {Collector::kTaskstats, "CollectTaskstats"}};
+  for (auto [kind, name] : kinds) {
+    std::unique_ptr<Collector> collector = Collector::Make(kind, threads);
+    if (!collector) {
+      printf("%-28s unavailable\n", name);
+      continue;
+    }
+    collector->Stat(pids.data(), pids.size(), stats.data(), 0);
+    Sample sample = Measure(repeats, [&] {
+      collector->Stat(pids.data(), pids.size(), stats.data(), 0);
+      sink = stats[0].utime;
+    });
+    Report(string(name) + "/live", "process", sample, calls);
+  }
+  for (int pid : pids) {
+    LinuxParser::Release(pid);
+  }
+}
+
+// Drilling into the threads of the busiest processes on the live /proc.
+// The benchmark itself is the busiest and is given kIdle threads, so
+// there is a process with many of them whatever the machine runs.
+static void BenchThreads(int threads) {
+  const int kIdle{256};
+  std::mutex mutex;
+  std::condition_variable done;
+  bool stop{false};
+  vector<std::thread> idle;
+  for (int i = 0; i < kIdle; ++i) {
+    idle.emplace_back([&] {
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait(lock, [&] { return stop; });
+    });
+  }
+  System system(threads);
+  system.Processes();
+  system.CollectThreads(8);
+  size_t read = system.TopThreads().Threads().size();
+  const int repeats = std::max<int>(1, 20000 / std::max<size_t>(read, 1));
+  Sample sample = Measure(repeats, [&] {
+    system.CollectThreads(8);
+    sink = system.TopThreads().Threads().size();
+  });
+  Report("TopThreads/live", "thread", sample,
+         static_cast<double>(std::max<size_t>(read, 1)) * repeats);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  done.notify_all();
+  for (std::thread& thread : idle) {
+    thread.join();
+  }
+}
+
+// Baselines are lines of "name metric value". A result regresses when
+// it exceeds its baseline by more than the tolerance for its kind: times
+// vary from run to run far more than syscall and allocation counts do.
+// Half a unit more is allowed so that counts of zero may wobble.
+static int Compare(const string& path, double time_tolerance,
+                   double count_tolerance) {
+  std::ifstream file(path);
+  if (!file) {
+    fprintf(stderr, "no baselines at %s\n", path.c_str());
+    return 0;
+  }
+  std::map<std::pair<string, string>, double> baselines;
+  string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line);
+    string name, metric;
+    double value;
+    if (line.empty() || line[0] == '#' ||
+        !(fields >> name >> metric >> value)) {
+      continue;
+    }
+    baselines[{name, metric}] = value;
+  }
+  int regressions{0};
+  for (const Result& result : results) {
+    auto baseline = baselines.find({result.name, result.metric});
+    if (Live(result) || baseline == baselines.end()) {
+      continue;
+    }
+    bool time = result.metric.compare(0, 3, "ns/") == 0;
+    double tolerance = time ? time_tolerance : count_tolerance;
+    double limit = baseline->second * (1 + tolerance) + 0.5;
+    if (result.value > limit) {
+      printf("REGRESSION %s %s: %.2f, baseline %.2f\n", result.name.c_str(),
+             result.metric.c_str(), result.value, baseline->second);
+      ++regressions;
+    }
+  }
+  return regressions;
+}
+
+static void Update(const string& path) {
+  std::ofstream file(path);
+  file << "# monitor_bench baselines: name metric value\n";
+  for (const Result& result : results) {
+    if (Live(result)) {
+      continue;
+    }
+    file << result.name << ' ' << result.metric << ' ' << result.value
+         << '\n';
+  }
+}
+
+static vector<size_t> ParseSizes(const string& list) {
+  vector<size_t> sizes;
+  std::istringstream items(list);
+  string item;
+  while (std::getline(items, item, ',')) {
+    sizes.push_back(std::stoul(item));
+  }
+  return sizes;
+}
+
+int main(int argc, char* argv[]) {
+  vector<size_t> sizes{1000, 10000};
+  int threads{1};
+  string root;
+  string baselines{MONITOR_BENCH_BASELINES};
+  double time_tolerance{1.0};
+  double count_tolerance{0.1};
+  bool update{false};
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--processes") == 0 && i + 1 < argc) {
+      sizes = ParseSizes(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = std::stoi(argv[++i]);
+    } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+      root = argv[++i];
+    } else if (strcmp(argv[i], "--baselines") == 0 && i + 1 < argc) {
+      baselines = argv[++i];
+    } else if (strcmp(argv[i], "--time-tolerance") == 0 && i + 1 < argc) {
+      time_tolerance = std::stod(argv[++i]);
+    } else if (strcmp(argv[i], "--count-tolerance") == 0 && i + 1 < argc) {
+      count_tolerance = std::stod(argv[++i]);
+    } else if (strcmp(argv[i], "--update") == 0) {
+      update = true;
+    } else {
+      fprintf(stderr,
+              "usage: %s [--processes N,N,...] [--threads N] [--root DIR] "
+              "[--baselines FILE] [--time-tolerance F] "
+              "[--count-tolerance F] [--update]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (root.empty()) {
+    char temporary[] = "/tmp/monitor_bench.XXXXXX";
+    if (mkdtemp(temporary) == nullptr) {
+      perror("mkdtemp");
+      return 1;
+    }
+    root = temporary;
+  }
+
+  for (size_t processes : {1000, 10000, 100000}) {
+    BenchRank(processes);
+  }
+  for (size_t processes : sizes) {
+    FakeProc fake(root + "/" + std::to_string(processes), processes);
+    LinuxParser::SetRoot(fake.Root());
+    BenchSystemParsers(processes);
+    BenchProcessParsers(fake.Pids());
+    BenchFdCache(fake.Pids());
+    BenchSystem(fake, processes, threads);
+    BenchMetricsLog(fake, processes, threads);
+    LinuxParser::SetRoot("");
+  }
+  rmdir(root.c_str());
+  BenchCollectors(threads);
+  BenchThreads(threads);
+
+  if (update) {
+    Update(baselines);
+    printf("baselines written to %s\n", baselines.c_str());
+    return 0;
+  }
+  int regressions = Compare(baselines, time_tolerance, count_tolerance);
+  if (regressions > 0) {
+    printf("%d regressions\n", regressions);
+    return 1;
+  }
+  return 0;
+}
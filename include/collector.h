@@ -0,0 +1,36 @@
+#ifndef COLLECTOR_H
+#define COLLECTOR_H
+
+#include <cstddef>
+#include <memory>
+
+#include "linux_parser.h"
+
+/*
+ * Collector class
+ * Where System::Processes() gets the counters of each process from.
+ * kProcfs parses /proc/<pid>/stat through the descriptor cache;
+ * kTaskstats asks the kernel's taskstats interface for binary records
+ * (see include/taskstats.h). Both fill in LinuxParser::ProcessStat, so
+ * everything after collection is the same whichever is used.
+ * Stat() is called from every worker of the thread pool at once, each
+ * with its own number.
+ */
+class Collector {
+ public:
+  enum Kind { kProcfs = 0, kTaskstats };
+
+  // nullptr if this kind cannot be used here.
+  static std::unique_ptr<Collector> Make(Kind kind, int workers);
+  virtual ~Collector() = default;
+
+  virtual const char* Name() const = 0;  // a string literal
+  // Clock ticks by which a process's starttime may differ from what
+  // /proc/<pid>/stat says: the same process must not look like a new one.
+  virtual long StartTimeSlack() const { return 0; }
+  // Counters of count processes; one that has gone away gets a state of 0.
+  virtual void Stat(const int* pids, std::size_t count,
+                    LinuxParser::ProcessStat* stats, int worker) = 0;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COUNTER_DELTAS_H
+#define COUNTER_DELTAS_H
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/*
+ * CounterDeltas class
+ * What Disks and Network share: the counters of named devices at the
+ * previous tick, matched by name against this tick's. Update() calls
+ * derive(load, current, previous, seconds) for every device in the
+ * order given; a device seen for the first time is compared against
+ * zero counters over the uptime, i.e. gets its average since boot.
+ * Counters and Load both have a char name[] member.
+ */
+template <typename Counters, typename Load>
+class CounterDeltas {
+ public:
+  template <typename Derive>
+  void Update(const std::vector<Counters>& devices, long uptime_ticks,
+              Derive derive) {
+    long hertz = sysconf(_SC_CLK_TCK);
+    interval_ = (float)(uptime_ticks - previous_ticks_) / hertz;
+    float uptime = (float)uptime_ticks / hertz;
+    previous_ticks_ = uptime_ticks;
+    const Counters zero{};
+    loads_.resize(devices.size());
+    for (std::size_t i = 0; i < devices.size(); ++i) {
+      const Counters& device = devices[i];
+      const Counters* before = &zero;
+      float seconds = uptime;
+      for (const Counters& previous : previous_) {
+        if (strcmp(previous.name, device.name) == 0) {
+          before = &previous;
+          seconds = interval_;
+          break;
+        }
+      }
+      Load& load = loads_[i];
+      load = Load{};
+      std::copy_n(device.name, sizeof(load.name), load.name);
+      if (seconds > 0) {
+        derive(load, device, *before, seconds);
+      }
+    }
+    previous_.assign(devices.begin(), devices.end());
+  }
+
+  const std::vector<Load>& Loads() const { return loads_; }
+  float Interval() const { return interval_; }  // s, of the last Update()
+
+  // Per second increase of a counter; none if it went backwards, as it
+  // does when a device is recreated.
+  static float Rate(long now, long before, float seconds) {
+    return std::max(now - before, 0L) / seconds;
+  }
+
+ private:
+  std::vector<Counters> previous_;
+  std::vector<Load> loads_;
+  long previous_ticks_{0};  // uptime at the previous Update()
+  float interval_{0};
+};
+
+#endif
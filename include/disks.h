@@ -0,0 +1,37 @@
+#ifndef DISKS_H
+#define DISKS_H
+
+#include <vector>
+
+#include "counter_deltas.h"
+#include "system_snapshot.h"
+
+/*
+ * DiskLoad
+ * What one device did over the last refresh interval.
+ */
+struct DiskLoad {
+  char name[32]{};
+  float read_rate{0};    // bytes/s
+  float write_rate{0};   // bytes/s
+  float read_wait{0};    // ms per completed read
+  float write_wait{0};   // ms per completed write
+  float utilization{0};  // share of the interval with I/O in flight
+};
+
+/*
+ * Disks class
+ * Throughput and latency of every device in the snapshot, worked out
+ * like Processor's CPU load: against the counters of the previous tick,
+ * through CounterDeltas.
+ */
+class Disks {
+ public:
+  void Update(const SystemSnapshot& snapshot);
+  const std::vector<DiskLoad>& Loads() const;  // in the snapshot's order
+
+ private:
+  CounterDeltas<DiskCounters, DiskLoad> deltas_;
+};
+
+#endif
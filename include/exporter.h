@@ -0,0 +1,52 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <chrono>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "process.h"
+#include "system.h"
+
+/*
+ * Exporter class
+ * Streams samples of a System as JSON Lines or CSV, without ncurses.
+ * Every sample is one "system" record followed by one "process" record
+ * per process. CSV records share one header; fields a record does not
+ * have are left empty.
+ * Numbers are formatted with std::to_chars and strings copied, all into
+ * one buffer that is reused from sample to sample and handed to write(2)
+ * once it fills up or the sample ends. In steady state a sample makes no
+ * allocations of its own.
+ * Once a write(2) fails nothing more is written, and Write() returns
+ * false with errno telling why.
+ */
+class Exporter {
+ public:
+  enum Format { kJson = 0, kCsv };
+
+  Exporter(int fd, Format format);
+  // time: when the sample was taken, which every record is stamped with.
+  bool Write(std::chrono::system_clock::time_point time, System& system,
+             const std::vector<Process>& processes);
+
+ private:
+  void WriteSystem(System& system, long time);
+  void WriteProcess(const Process& process, long time);
+  void Field(std::string_view name);  // separator, and the key for JSON
+  void Text(std::string_view text);   // quoted and escaped
+  void Raw(std::string_view text);
+  void Number(long value);
+  void Number(double value);
+  bool Flush();
+
+  int fd_;
+  Format format_;
+  bool first_field_{true};
+  std::vector<char> buffer_;
+  std::size_t size_{0};
+  bool failed_{false};  // a write(2) failed; errno is left as it set it
+};
+
+#endif
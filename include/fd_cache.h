@@ -0,0 +1,65 @@
+#ifndef FD_CACHE_H
+#define FD_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+/*
+ * FdCache class
+ * Keeps /proc/<pid>/stat and /proc/<pid>/status open between ticks and
+ * re-reads them with pread at offset 0, which skips the procfs path
+ * lookup of a fresh open. A descriptor stays bound to the process it was
+ * opened for: once that exits, reads fail with ESRCH or come back empty
+ * and the descriptors are closed. The number of processes with open
+ * descriptors is capped below RLIMIT_NOFILE, whose soft limit is raised
+ * to the hard one first. Once the cache is full, processes it does not
+ * hold are read with a plain open and close until one of those it holds
+ * exits: a scan visits every process in turn, so evicting the least
+ * recently read one would only evict each entry before it is read again.
+ * Pids are spread over independently locked shards, so threads
+ * collecting different processes rarely wait for each other. Each shard
+ * is an open addressing table allocated in full up front, so keeping,
+ * adding and dropping processes never allocates.
+ */
+class FdCache {
+ public:
+  enum File { kStat = 0, kStatus, kFiles };
+
+  explicit FdCache(std::size_t capacity = DefaultCapacity());
+  ~FdCache();
+  FdCache(const FdCache&) = delete;
+  FdCache& operator=(const FdCache&) = delete;
+
+  std::string_view Read(int pid, File file);
+  void Forget(int pid);
+  void Clear();
+  std::size_t Size() const;
+  static std::size_t DefaultCapacity();
+
+ private:
+  struct Entry {
+    int pid{-1};  // -1 if the slot is free
+    int fds[kFiles]{-1, -1};
+  };
+  struct Shard {
+    std::size_t Home(int pid) const;
+    Entry* Find(int pid);
+    Entry* Insert(int pid);  // null if the shard is full
+    void Erase(int pid);
+
+    mutable std::mutex mutex;
+    std::size_t capacity{1};  // processes held at most
+    std::size_t size{0};
+    int shift{0};               // of the hash, for slots.size() slots
+    std::vector<Entry> slots;   // linear probing, at least half free
+  };
+  static const int kShards{16};
+  Shard& ShardOf(int pid);
+
+  Shard shards_[kShards];
+};
+
+#endif
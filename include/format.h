@@ -1,10 +1,16 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstddef>
 #include <string>
 
 namespace Format {
 std::string ElapsedTime(long times);  // Done: See src/format.cpp
-};                                    // namespace Format
+// HH:MM:SS into buffer, without allocating; returns buffer.
+const char* ElapsedTime(long seconds, char* buffer, std::size_t size);
+// 1023, 1.0K, 12.3M ... into buffer, at most 5 characters; "-" if the
+// value is negative, i.e. unknown.
+const char* Bytes(double bytes, char* buffer, std::size_t size);
+};  // namespace Format
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,93 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "disks.h"
+#include "history.h"
+#include "network.h"
+#include "process_table.h"
+#include "processor.h"
+#include "system.h"
+
+/*
+ * Frame struct
+ * Everything one screen shows, copied out of System by Capture(). The
+ * thread that draws a Frame never touches System or /proc, so sampling
+ * and drawing can run on different threads.
+ * Frames are meant to be reused: once the row vector has grown, a
+ * Capture() copies without allocating.
+ * Sparklines and averages come from the History the sampler keeps, so
+ * they cost no reads of /proc either.
+ */
+struct Frame {
+  static constexpr std::chrono::seconds kSpan{60};  // of min, max, average
+  static constexpr std::size_t kTrail{30};     // ticks in system sparklines
+  static constexpr std::size_t kRowTrail{12};  // ticks in process ones
+
+  struct Row {
+    int pid{0};
+    char user[32]{};  // cut short if longer
+    float cpu{0};
+    long ram{0};      // KiB
+    float read_rate{-1};   // storage bytes/s, -1 if unknown
+    float write_rate{-1};  // storage bytes/s, -1 if unknown
+    long uptime{0};   // CPU seconds, children included (TIME+)
+    // A copy: the ProcessTable reuses the strings of commands gone.
+    // Assigning keeps the capacity, so reused frames rarely allocate.
+    std::string command;
+    float average{0};  // CPU over kSpan, NaN if it was never recorded
+    float trail[kRowTrail]{};  // CPU, oldest first; NaN where unknown
+  };
+
+  // One thread of a process drilled into.
+  struct ThreadRow {
+    int tid{0};
+    int pid{0};
+    char state{0};
+    float cpu{0};
+    long time{0};  // seconds of CPU
+    char name[LinuxParser::kCommSize]{};
+    std::string command;  // of its process, as in Row
+  };
+
+  void Capture(System& system, const History& history, std::size_t count,
+               bool with_threads = false);
+
+  std::chrono::system_clock::time_point time;  // when the scan started
+  std::string os;
+  std::string kernel;
+  CpuLoad cpu;
+  int cores{0};
+  float memory{0};
+  std::vector<DiskLoad> disks;
+  std::vector<InterfaceLoad> interfaces;
+  float retransmit_rate{0};   // TCP segments/s
+  float retransmit_share{0};  // of TCP segments sent
+  History::Summary cpu_range;
+  History::Summary memory_range;
+  float cpu_trail[kTrail]{};
+  float memory_trail[kTrail]{};
+  int total_processes{0};
+  int running_processes{0};
+  long uptime{0};
+  int started{0};
+  int exited{0};
+  int short_lived{-1};  // -1 unless process events are watched
+  long opens_per_tick{0};
+  double collection_time{0};
+  int threads{0};
+  const char* collector{""};  // System::CollectorName(); static storage
+  ProcessTable::Column sort{ProcessTable::kCpu};
+  std::size_t processes{0};  // visible processes, not only those in rows
+  std::vector<Row> rows;     // the highest ranked by sort, in order
+  // Only captured when asked for; the busiest first.
+  std::size_t thread_count{0};  // threads read, not only those in rows
+  std::size_t threads_skipped{0};  // over ThreadTable::kMaxThreads
+  std::vector<ThreadRow> thread_rows;
+};
+
+#endif
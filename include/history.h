@@ -0,0 +1,79 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "system.h"
+
+/*
+ * History class
+ * The last ticks of the system CPU and memory utilization and of the CPU
+ * of the busiest processes, kept in a ring that never grows: how many
+ * ticks fit is worked out once from a budget in bytes.
+ *
+ * Values are stored column by column, one contiguous array per series,
+ * so a range query or a sparkline walks adjacent floats.
+ * Every tick records the processes with the highest CPU in one of a fixed
+ * number of slots. A process keeps its slot while it stays among them;
+ * a newcomer takes the slot that has gone unused the longest, once every
+ * process still among them has claimed its own. A slot
+ * holds NaN for the ticks its process was not recorded in.
+ *
+ * Not thread safe; the Sampler records and reads it on its own thread.
+ */
+class History {
+ public:
+  enum Series { kCpu = 0, kMemory, kSeries };
+  using Clock = std::chrono::system_clock;
+
+  // min, max and mean of the recorded values in a range.
+  struct Summary {
+    float min{0};
+    float max{0};
+    float average{0};
+    std::size_t samples{0};  // 0 if nothing was recorded in the range
+  };
+
+  explicit History(std::size_t budget, std::size_t processes = 32);
+  std::size_t Capacity() const;  // ticks the budget holds
+  std::size_t Size() const;      // ticks held, up to Capacity()
+  std::size_t Bytes() const;     // memory taken by the series
+
+  // System::Processes() must have run for this tick.
+  void Record(Clock::time_point time, System& system);
+  Summary Range(Series series, std::chrono::milliseconds span) const;
+  Summary Range(int pid, long starttime,
+                std::chrono::milliseconds span) const;
+  // The last count values, oldest first; NaN where there is none.
+  void Trail(Series series, float* values, std::size_t count) const;
+  void Trail(int pid, long starttime, float* values,
+             std::size_t count) const;
+
+ private:
+  struct Slot {
+    int pid{-1};
+    long starttime{-1};
+    std::uint64_t since{0};  // first tick recorded for this process
+    std::uint64_t last{0};   // tick after the last one recorded for it
+  };
+
+  long Find(int pid, long starttime) const;
+  std::size_t Ticks(std::uint64_t since,
+                    std::chrono::milliseconds span) const;
+  Summary Summarize(const float* column, std::size_t count) const;
+  void Copy(const float* column, std::uint64_t since, float* values,
+            std::size_t count) const;
+
+  std::size_t capacity_;
+  std::uint64_t ticks_{0};  // ticks ever recorded; the next goes here
+  std::vector<std::int64_t> time_;     // ms since the epoch, per tick
+  std::vector<float> system_;          // kSeries columns of capacity_
+  std::vector<Slot> slots_;
+  std::vector<std::size_t> newcomers_;  // Record()'s, indices into Top()
+  std::vector<float> processes_;       // one column per slot
+};
+
+#endif
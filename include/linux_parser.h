@@ -15,13 +15,41 @@ const std::string kStatFilename{"/stat"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
 const std::string kVersionFilename{"/version"};
+const std::string kIoFilename{"/io"};
+const std::string kDiskstatsFilename{"/diskstats"};
+const std::string kNetDevFilename{"/net/dev"};
+const std::string kSnmpFilename{"/net/snmp"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
 
+// Directory the paths above are resolved against, "" for the live system.
+// Pointing it at a recorded copy replays that copy.
+enum SystemFile {
+  kStatFile = 0,
+  kMeminfoFile,
+  kUptimeFile,
+  kVersionFile,
+  kOSFile,
+  kPasswordFile,
+  kDiskstatsFile,
+  kNetDevFile,
+  kSnmpFile,
+  kSystemFiles
+};
+void SetRoot(const std::string& root, bool reload_users = true);
+const std::string& Root();
+const std::string& ProcDirectory();        // Root() + kProcDirectory
+const std::string& Path(SystemFile file);  // Root() + the path of file
+
+// Instrumentation
+long FileOpens();
+
 // System
 float MemoryUtilization();
 long UpTime();
 std::vector<int> Pids();
+void Pids(std::vector<int>& pids, bool sorted = false);
+void Tasks(int pid, std::vector<int>& tids);  // threads of a process
 int TotalProcesses();
 int RunningProcesses();
 std::string OperatingSystem();
@@ -47,12 +75,55 @@ long ActiveJiffies(int pid);
 long IdleJiffies();
 
 // Processes
+// Counters of /proc/[PID]/stat, in clock ticks.
+struct ProcessStat {
+  char state{0};      // R, S, D, Z, ...
+  long flags{0};      // PF_* flags of the task
+  long utime{0};
+  long stime{0};
+  long cutime{0};
+  long cstime{0};
+  long starttime{0};  // identifies the process together with its pid
+};
+const long kPfKthread{0x00200000};  // ProcessStat::flags of a kernel thread
+bool Stat(int pid, ProcessStat& stat);
+const int kCommSize{16};  // a task name and its terminating zero
+bool TaskStat(int pid, int tid, ProcessStat& stat, char (&name)[kCommSize]);
+bool IsKernelThread(const ProcessStat& stat);
+float CpuUtilization(const ProcessStat& stat, long uptime);
+// Fields of /proc/[PID]/status, sizes in KiB.
+enum StatusField {
+  kStatusUid = 1 << 0,
+  kStatusVmSize = 1 << 1,
+  kStatusVmRss = 1 << 2,
+  kStatusThreads = 1 << 3,
+  kStatusVoluntary = 1 << 4,
+  kStatusNonvoluntary = 1 << 5
+};
+struct ProcessStatus {
+  long uid{0};
+  long vm_size{0};
+  long vm_rss{0};
+  long threads{0};
+  long voluntary_switches{0};
+  long nonvoluntary_switches{0};
+};
+bool Status(int pid, unsigned mask, ProcessStatus& status);
+// Bytes of /proc/[PID]/io that reached or came from storage.
+struct ProcessIo {
+  long read_bytes{0};
+  long write_bytes{0};
+};
+bool Io(int pid, ProcessIo& io);  // false if gone or not ours to read
 std::string Command(int pid);
-std::string Ram(int pid);
+long Ram(int pid);
 std::string Uid(int pid);
 std::string User(int pid);
+std::string UserName(int uid);
+void RevalidateUsers();
 long UpTime(int pid);
 float CpuUtilization(int pid);
+void Release(int pid);
 };  // namespace LinuxParser
 
 #endif
\ No newline at end of file
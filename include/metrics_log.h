@@ -0,0 +1,149 @@
+#ifndef METRICS_LOG_H
+#define METRICS_LOG_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "frame.h"
+#include "process.h"
+#include "process_table.h"
+#include "system.h"
+
+/*
+ * Metrics log
+ * Every tick of the system and its processes, appended to a binary log
+ * that costs a few bytes per process per tick. A log is a directory of
+ * files NNNNNN.mlog; a file is closed and the next one started once it
+ * has grown past a size.
+ *
+ * A file is the magic "MLOG", a version byte and then records, each a
+ * tag byte, a varint length and a payload:
+ *   string  text, numbered from 0 in the order they appear in the file
+ *   tick    the system values and the processes of one tick
+ * Integers are LEB128 varints; signed ones are zigzag encoded. Fractions
+ * are kept in units of 1/10000.
+ * Processes are written in pid order; each starts with its pid less the
+ * previous one and a bit telling whether it is new. A new process is
+ * written in full, with its user and command as string numbers; one seen
+ * the tick before only as the change of its CPU, memory and CPU time.
+ * Every kKeyframe-th tick, and the first of each file, treats every
+ * process as new, so reading from there needs no earlier tick. Strings
+ * are written once per file, so each file can be read on its own.
+ */
+namespace MetricsLog {
+const int kVersion{1};
+const int kKeyframe{60};  // ticks
+
+/*
+ * Writer class
+ * Appends ticks to the newest file of a log directory, after any files
+ * already there. Buffers are reused, so in steady state only processes
+ * new to the log allocate. A Write() that fails closes its file, and
+ * the next one starts another.
+ */
+class Writer {
+ public:
+  Writer(std::string directory, std::size_t max_size);
+  ~Writer();
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  // System::Processes() must have run for this tick.
+  bool Write(std::chrono::system_clock::time_point time, System& system,
+             const std::vector<Process>& processes);
+  std::size_t Bytes() const;  // written so far, over all files
+
+ private:
+  struct Entry {
+    int pid;
+    long starttime;
+    long cpu;     // 1/10000
+    long ram;     // KiB
+    long cpu_time;  // seconds, children included
+    const Process* process;  // only while the tick is written
+  };
+
+  bool Open();
+  std::uint64_t Intern(const std::string& text);
+
+  std::string directory_;
+  std::size_t max_size_;
+  int fd_{-1};
+  int file_{-1};          // number of the open file, or of the last one
+  std::size_t size_{0};   // of the open file
+  std::size_t bytes_{0};  // over all files
+  long ticks_{0};         // in the open file
+  std::int64_t time_{0};  // of the last tick, ms since the epoch
+  std::unordered_map<std::string, std::uint64_t> strings_;  // of the file
+  std::vector<Entry> previous_;
+  std::vector<Entry> current_;
+  std::vector<std::uint8_t> payload_;
+  std::vector<std::uint8_t> out_;
+};
+
+/*
+ * Reader class
+ * Maps the files of a log directory and indexes their ticks, so that any
+ * tick can be turned into a Frame. Reading a tick decodes from the last
+ * keyframe before it, or only that tick when it follows the one read
+ * last, as it does when stepping forward.
+ * Process rows carry no sparklines: a log has no History.
+ */
+class Reader {
+ public:
+  explicit Reader(const std::string& directory);
+  ~Reader();
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  std::size_t Ticks() const;
+  std::chrono::system_clock::time_point Time(std::size_t tick) const;
+  // The last tick at or before time, or the first one.
+  std::size_t Find(std::chrono::system_clock::time_point time) const;
+  bool Read(std::size_t tick, ProcessTable::Column sort, std::size_t count,
+            Frame& frame);
+
+ private:
+  struct File {
+    const std::uint8_t* data{nullptr};
+    std::size_t size{0};
+    std::vector<std::string> strings;
+  };
+  struct Tick {
+    std::size_t file;
+    std::size_t offset;  // of the payload
+    std::size_t size;
+    std::int64_t time;  // ms since the epoch
+    bool keyframe;
+  };
+  struct Entry {
+    int pid;
+    long cpu;
+    long ram;
+    long cpu_time;
+    const std::string* user;
+    const std::string* command;
+  };
+
+  void Index(std::size_t file);
+  bool Decode(std::size_t tick, Frame& frame);
+  bool Step(std::size_t tick, Frame& frame);
+  void Summarize(std::size_t tick, Frame& frame);
+
+  std::vector<File> files_;
+  std::vector<Tick> ticks_;
+  // Processes of tick decoded_, if valid_; next_ is the one after.
+  std::size_t decoded_{0};
+  bool valid_{false};
+  std::vector<Entry> entries_;
+  std::vector<Entry> next_;
+  std::vector<std::uint32_t> order_;
+  Frame header_;  // system values of the ticks Summarize() looks at
+};
+};  // namespace MetricsLog
+
+#endif
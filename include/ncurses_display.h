@@ -2,15 +2,29 @@
 #define NCURSES_DISPLAY_H
 
 #include <curses.h>
+#include <chrono>
+#include <cstddef>
 
-#include "process.h"
+#include "frame.h"
+#include "metrics_log.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
-void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
-std::string ProgressBar(float percent);
+// Both fill the terminal with as many process rows as fit.
+void Display(System& system,
+             std::chrono::milliseconds interval = std::chrono::seconds(1),
+             std::size_t history = 16 << 20);  // bytes of History
+void Scrub(MetricsLog::Reader& log, size_t tick = 0);
+void DisplaySystem(const Frame& frame, WINDOW* window);
+void DisplayDisks(const Frame& frame, WINDOW* window);
+void DisplayNetwork(const Frame& frame, WINDOW* window);
+void DisplayProcesses(const Frame& frame, WINDOW* window, int n,
+                      size_t offset = 0);
+void DisplayThreads(const Frame& frame, WINDOW* window, int n,
+                    size_t offset = 0);
+const char* ProgressBar(float percent, char* buffer, size_t size);
+const char* Sparkline(const float* values, size_t count, float scale,
+                      char* buffer);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <vector>
+
+#include "counter_deltas.h"
+#include "system_snapshot.h"
+
+/*
+ * InterfaceLoad
+ * What one network interface did over the last refresh interval.
+ */
+struct InterfaceLoad {
+  char name[16]{};
+  float receive_rate{0};          // bytes/s
+  float transmit_rate{0};         // bytes/s
+  float receive_packet_rate{0};   // packets/s
+  float transmit_packet_rate{0};  // packets/s
+  float drop_rate{0};             // packets/s dropped either way
+};
+
+/*
+ * Network class
+ * Throughput of every interface in the snapshot and the TCP retransmit
+ * rate, worked out like Disks: against the counters of the previous
+ * tick, through CounterDeltas.
+ */
+class Network {
+ public:
+  void Update(const SystemSnapshot& snapshot);
+  const std::vector<InterfaceLoad>& Loads() const;  // in the snapshot's order
+  float RetransmitRate() const;   // TCP segments/s sent again
+  float RetransmitShare() const;  // of all TCP segments sent
+
+ private:
+  CounterDeltas<InterfaceCounters, InterfaceLoad> deltas_;
+  long previous_out_segments_{0};
+  long previous_retransmits_{0};
+  float retransmit_rate_{0};
+  float retransmit_share_{0};
+};
+
+#endif
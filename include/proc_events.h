@@ -0,0 +1,58 @@
+#ifndef PROC_EVENTS_H
+#define PROC_EVENTS_H
+
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * ProcEvents class
+ * Listens to the kernel's proc connector, which announces every fork,
+ * exec and exit over netlink, so the process list can be kept up to date
+ * without reading /proc, and processes that start and end between two
+ * scans are at least counted.
+ * Subscribing needs CAP_NET_ADMIN in the initial network namespace; when
+ * it fails Active() is false and the caller goes on scanning /proc.
+ * Events are read on a thread of their own, so a burst of forks does not
+ * overflow the socket while the monitor sleeps. If the kernel drops
+ * events all the same, the next Drain() says so.
+ * Only processes count, not the threads inside them.
+ */
+class ProcEvents {
+ public:
+  // What happened between two calls to Drain().
+  struct Changes {
+    std::vector<int> started;  // sorted; forked and still running
+    std::vector<int> exited;   // sorted; forked before the last Drain()
+    std::vector<int> execed;   // sorted; ran a new program
+    int short_lived{0};        // forked and exited in between
+    bool lost{false};          // events were dropped; scan /proc
+  };
+
+  ProcEvents();
+  ~ProcEvents();
+  ProcEvents(const ProcEvents&) = delete;
+  ProcEvents& operator=(const ProcEvents&) = delete;
+
+  bool Active() const;
+  void Drain(Changes& changes);
+
+ private:
+  bool Subscribe();
+  bool Receive(int* ack);
+  void Run();
+
+  int socket_{-1};
+  int wake_{-1};  // eventfd that stops Run()
+  std::mutex mutex_;
+  std::unordered_set<int> started_;
+  std::vector<int> exited_;
+  std::vector<int> execed_;
+  int short_lived_{0};
+  bool lost_{false};
+  bool failed_{false};  // Run() has given up on the socket
+  std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <cstddef>
+#include <string_view>
+
+/*
+ * ProcReader
+ * Allocation free reading of small text files such as those in /proc.
+ * A file is read with open/read into a buffer owned by the calling
+ * thread and handed back as a string_view. The buffer is reused, so a
+ * view is only valid until the same thread reads the next file.
+ */
+namespace ProcReader {
+// Reading
+int Open(const char* path, int flags);  // counted open(2)
+void Close(int fd);                     // counted close(2)
+long ReadDirectory(int fd, char* buffer, std::size_t size);  // getdents64
+std::string_view Read(const char* path);
+std::string_view ReadFd(int fd);  // whole file, from offset 0
+std::string_view ReadPid(int pid, const char* filename);  // /proc/<pid>/...
+long Opens();     // files opened by all threads since start-up
+long Syscalls();  // open, read, close and getdents64 calls since start-up
+void CountSyscalls(long count);  // add calls made elsewhere to Syscalls()
+
+// Tokenizing
+std::string_view NextLine(std::string_view& text);
+std::string_view NextToken(std::string_view& text);
+void SkipTokens(std::string_view& text, int count);
+std::string_view Value(std::string_view text, std::string_view key);
+
+// Numbers
+long ParseLong(std::string_view token);
+double ParseDouble(std::string_view token);
+};  // namespace ProcReader
+
+#endif
@@ -1,7 +1,11 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <cstdint>
 #include <string>
+
+#include "process_table.h"
+
 /*
  * Process class
  * Represents a single system process.
@@ -10,27 +14,27 @@
  */
 class Process {
  public:
-  void setPid(int pid);
+  Process(ProcessTable* table, std::uint32_t row);
   int Pid() const;
   std::string User() const;
-  std::string Command() const;
+  const std::string& Command() const;
   float CpuUtilization() const;
-  std::string Ram() const;
-  long int UpTime() const;
+  long Ram() const;  // VmRSS in KiB
+  float ReadRate() const;   // storage bytes/s, -1 if unknown
+  float WriteRate() const;  // storage bytes/s, -1 if unknown
+  long int UpTime() const;  // CPU seconds, children included
+  long StartTime() const;  // with the pid, tells a reused pid apart
   bool operator<(Process const& a) const;
 
   /*
    * Design:
-   * determine process information when Process object is created.
-   * Save results from LinuxParser and return values from private members.
+   * A Process is a view of one row of the ProcessTable, which holds the
+   * values column by column. It is valid until the next scan.
+   * Accessors of fields the table has not read yet read them on demand.
    */
  private:
-  int pid_;
-  std::string user_;
-  std::string command_;
-  float cpuUtilization_;
-  std::string ram_;
-  int uptime_;
+  ProcessTable* table_;
+  std::uint32_t row_;
 };
 
-#endif
\ No newline at end of file
+#endif
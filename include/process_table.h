@@ -0,0 +1,118 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "system_snapshot.h"
+
+/*
+ * ProcessTable class
+ * Every known process as one row of a structure of arrays: pid, CPU,
+ * memory, time and uid each live in their own contiguous column, and
+ * command lines are interned in a side pool. Sorting by any column
+ * walks one numeric array and never parses or touches a string.
+ *
+ * A row lives as long as the process it describes; (pid, starttime)
+ * identifies it. Update() only takes the counters of /proc/[pid]/stat,
+ * which is all ranking by CPU needs. Command, uid and memory are read
+ * the first time they are asked for, so only rows that are shown pay for
+ * them. Command and uid only change when a process runs a new program,
+ * which the caller learns of and Forget()s them; memory and I/O are read
+ * again after each Update(). A command string lives only as long as
+ * some row uses it, so a reference to it lasts only until the next
+ * Insert(), Erase() or Forget().
+ * I/O rates cover the time between two reads of /proc/[pid]/io, so a
+ * row that is only shown now and then gets the average since it was
+ * last shown. The first read of a row has nothing to compare against
+ * and shows 0; a process we may not read gives no rate.
+ *
+ * Update() may run for different rows on different threads; everything
+ * else expects a single thread.
+ */
+class ProcessTable {
+ public:
+  enum Column { kPid = 0, kUser, kCpu, kRam, kUpTime, kRead, kWrite };
+  // Fields read on first use rather than on every tick.
+  enum Field {
+    kLoadedUid = 1 << 0,
+    kLoadedCommand = 1 << 1,
+    kLoadedRam = 1 << 2,
+    kLoadedIo = 1 << 3
+  };
+
+  std::size_t Size() const;
+  long Find(int pid) const;  // row of pid, -1 if there is none
+  std::uint32_t Insert(int pid, long starttime);
+  void Erase(int pid);
+  void Update(std::uint32_t row, const LinuxParser::ProcessStat& stat,
+              const SystemSnapshot& snapshot, long tick);
+  bool Visible(std::uint32_t row, long tick) const;
+  void Rank(Column column, std::size_t count, long tick,
+            std::vector<std::uint32_t>& rows);
+
+  // Columns
+  int Pid(std::uint32_t row) const;
+  long StartTime(std::uint32_t row) const;
+  float Cpu(std::uint32_t row) const;
+  long UpTime(std::uint32_t row) const;  // CPU seconds, not age
+  bool Loaded(std::uint32_t row, Field field) const;
+  void Forget(std::uint32_t row, Field field);  // read it again on use
+  int Uid(std::uint32_t row);
+  long Ram(std::uint32_t row);  // VmRSS in KiB
+  float ReadRate(std::uint32_t row);   // bytes/s, -1 if unknown
+  float WriteRate(std::uint32_t row);  // bytes/s, -1 if unknown
+  const std::string& Command(std::uint32_t row);
+
+ private:
+  void LoadStatus(std::uint32_t row);
+  void LoadIo(std::uint32_t row);
+  std::uint32_t Intern(std::string_view text);
+  void Release(std::uint32_t index);
+  template <typename T>
+  void RankBy(const std::vector<T>& column, bool descending, long tick);
+  void RankByUser(long tick);
+
+  std::unordered_map<int, std::uint32_t> rows_;  // pid -> row
+  std::vector<int> pid_;
+  std::vector<long> starttime_;
+  std::vector<long> last_seen_;     // tick of the last Update()
+  std::vector<std::uint8_t> hidden_;  // kernel thread or zombie
+  std::vector<std::uint8_t> loaded_;  // Field bits that hold current values
+  std::vector<float> cpu_;
+  std::vector<long> prev_active_;  // utime + stime at the last Update()
+  std::vector<long> prev_total_;   // machine jiffies at the last Update()
+  std::vector<long> ram_;
+  std::vector<long> uptime_;
+  std::vector<float> read_rate_;
+  std::vector<float> write_rate_;
+  std::vector<long> read_bytes_;   // at the last LoadIo()
+  std::vector<long> write_bytes_;  // at the last LoadIo()
+  std::vector<double> io_time_;    // s, steady clock; 0 before any
+  std::vector<int> uid_;
+  std::vector<std::uint32_t> command_;  // index into strings_
+
+  // Interned command lines, counted by the rows that use them; a deque
+  // keeps the strings in place, so the views used as keys stay valid.
+  // Slots of strings nobody uses are listed in free_ for reuse.
+  std::deque<std::string> strings_;
+  std::vector<std::uint32_t> references_;
+  std::vector<std::uint32_t> free_;
+  std::unordered_map<std::string_view, std::uint32_t> interned_;
+
+  // (key, row) pairs reused by Rank()
+  std::vector<std::pair<double, std::uint32_t>> ranking_;
+  // Reused by RankByUser(): (uid, place of its name), by uid, and
+  // (name, index into user_ranks_), by name.
+  std::vector<std::pair<int, std::uint32_t>> user_ranks_;
+  std::vector<std::pair<std::string, std::uint32_t>> user_names_;
+};
+
+#endif
@@ -1,9 +1,46 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <vector>
+
+#include "system_snapshot.h"
+
+/*
+ * CpuLoad
+ * Share of one refresh interval spent in each state, 0.0 - 1.0.
+ */
+struct CpuLoad {
+  float utilization{0};  // everything but idle and iowait
+  float user{0};         // user + nice
+  float system{0};       // system + irq + softirq
+  float iowait{0};
+  float steal{0};
+};
+
+/*
+ * Processor class
+ * Utilization over the last refresh interval, for the aggregate "cpu"
+ * line and for every core. Keeps the previous counters so that a busy
+ * host shows as busy, no matter how long it has been up.
+ */
 class Processor {
  public:
+  void Update(const SystemSnapshot& snapshot);
   float Utilization();  // Done: See src/processor.cpp
+  const CpuLoad& Load() const;
+  int Cores() const;
+  const CpuLoad& Core(int core) const;
+
+ private:
+  // Counters from the previous tick next to the load derived from them.
+  struct Sample {
+    CpuTimes previous;
+    CpuLoad load;
+  };
+  static void Advance(Sample& sample, const CpuTimes& current);
+
+  Sample cpu_;
+  std::vector<Sample> cores_;  // sized on the first tick
 };
 
-#endif
\ No newline at end of file
+#endif
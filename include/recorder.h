@@ -0,0 +1,22 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+ * Recorder namespace
+ * Freezes the files the monitor reads so a run can be repeated.
+ * Every tick becomes a directory DIR/NNNNNN that mirrors the live tree:
+ * proc/{stat,meminfo,uptime,version}, proc/<pid>/{stat,status,cmdline},
+ * etc/os-release and etc/passwd. Replaying points LinuxParser::SetRoot()
+ * at one tick directory after the other.
+ */
+namespace Recorder {
+bool Record(const std::string& dir, int ticks,
+            std::chrono::milliseconds interval);
+std::vector<std::string> Ticks(const std::string& dir);
+};  // namespace Recorder
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+#include "frame.h"
+#include "history.h"
+#include "process_table.h"
+#include "system.h"
+#include "triple_buffer.h"
+
+/*
+ * Sampler class
+ * Scans the system on its own thread, one tick per interval, and hands
+ * each result to the drawing thread as a Frame through a TripleBuffer.
+ * Ticks are scheduled on a fixed grid: a scan that runs long does not
+ * push the following ones back. If a scan overruns a whole interval, the
+ * missed ticks are skipped.
+ * Request() changes the sort column and how many rows a Frame ranks,
+ * and whether it lists the threads of the busiest processes too.
+ * The sampler answers it at once with a Frame ranked from the last scan,
+ * so sorting and scrolling do not wait for the next tick.
+ * Every scan is also added to a History, which frames draw their
+ * sparklines from.
+ * The System belongs to the sampler thread while the Sampler lives.
+ */
+class Sampler {
+ public:
+  Sampler(System& system, std::chrono::milliseconds interval,
+          std::size_t history);  // bytes of History to keep
+  ~Sampler();
+  Sampler(const Sampler&) = delete;
+  Sampler& operator=(const Sampler&) = delete;
+
+  void Request(ProcessTable::Column sort, std::size_t rows,
+               bool threads = false);
+  bool Poll();                 // true if Front() has changed
+  const Frame& Front() const;  // latest frame picked up by Poll()
+
+ private:
+  void Run();
+
+  System& system_;
+  const std::chrono::milliseconds interval_;
+  History history_;
+  TripleBuffer<Frame> frames_;
+  std::atomic<int> sort_;
+  std::atomic<std::size_t> rows_{0};
+  std::atomic<bool> threads_{false};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool requested_{false};
+  bool stop_{false};
+  std::thread thread_;
+};
+
+#endif
@@ -1,11 +1,22 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "collector.h"
+#include "disks.h"
+#include "network.h"
 #include "process.h"
+#include "proc_events.h"
+#include "process_table.h"
 #include "processor.h"
+#include "system_snapshot.h"
+#include "thread_pool.h"
+#include "thread_table.h"
 
 /*
  * System class
@@ -16,20 +27,83 @@
 
 class System {
  public:
-  System();
+  explicit System(int threads = std::thread::hardware_concurrency());
+  void Refresh();                     // re-read system wide values
+  void Replay(std::vector<std::string> ticks);  // see src/system.cpp
+  bool WatchEvents();                 // see src/system.cpp
+  bool UseCollector(Collector::Kind kind);  // see src/system.cpp
+  const char* CollectorName() const;
+  const SystemSnapshot& Snapshot() const;
+  long OpensPerTick() const;          // files opened by the last tick
+  double CollectionTime() const;      // seconds the last Processes() took
+  int Threads() const;                // threads collecting processes
+  int Started() const;                // processes new in the last scan
+  int Exited() const;                 // processes gone in the last scan
+  int ShortLived() const;             // gone before a scan saw them
+  std::size_t Visible() const;        // processes the last scan listed
   Processor& Cpu();                   // Done: See src/system.cpp
+  const std::vector<DiskLoad>& DiskLoads() const;
+  const Network& Net() const;
   std::vector<Process>& Processes();  // Done: See src/system.cpp
+  const std::vector<Process>& Top(std::size_t count);
+  const std::vector<Process>& Top(std::size_t count,
+                                  ProcessTable::Column column);
+  void CollectThreads(std::size_t processes);  // see src/system.cpp
+  const ThreadTable& TopThreads() const;
+  void SortBy(ProcessTable::Column column);
+  ProcessTable::Column SortColumn() const;
   float MemoryUtilization();          // Done: See src/system.cpp
   long UpTime();                      // Done: See src/system.cpp
   int TotalProcesses();               // Done: See src/system.cpp
   int RunningProcesses();             // Done: See src/system.cpp
-  std::string Kernel();               // Done: See src/system.cpp
-  std::string OperatingSystem();      // Done: See src/system.cpp
+  const std::string& Kernel() const;           // Done: See src/system.cpp
+  const std::string& OperatingSystem() const;  // Done: See src/system.cpp
 
   // reference to Processor object and vector of processes.
  private:
+  void Collect(std::size_t chunk, int worker);
+  void ReadRelease();
+
   Processor cpu_ = {};
+  Disks disks_ = {};
+  Network network_ = {};
+  SystemSnapshot snapshot_ = {};
+  std::string operating_system_ = {};
+  std::string kernel_ = {};
+  long opens_at_refresh_{0};
+  long opens_per_tick_{0};
+  // Processes by pid, kept from tick to tick.
+  ProcessTable table_ = {};
+  long tick_{0};
+  // Views of the rows of table_ that are shown, in no particular order.
   std::vector<Process> processes_ = {};
+  // Rows picked by Top() and views of them.
+  ProcessTable::Column sort_{ProcessTable::kCpu};
+  std::vector<std::uint32_t> ranked_ = {};
+  std::vector<Process> top_ = {};
+  // Threads of the busiest processes, when drilled into.
+  ThreadTable top_threads_ = {};
+  // Collection runs in parallel over chunks of pids_. Processes new to
+  // the table go to the collecting worker's own buffer first and are
+  // merged once all workers are done.
+  using Fresh = std::pair<int, LinuxParser::ProcessStat>;
+  ThreadPool pool_;
+  std::vector<int> pids_ = {};           // sorted
+  std::vector<int> previous_pids_ = {};  // sorted, from the last tick
+  std::vector<int> started_ = {};
+  std::vector<int> exited_ = {};
+  // Forks, execs and exits, when they are watched; see WatchEvents().
+  std::unique_ptr<ProcEvents> events_ = {};
+  ProcEvents::Changes changes_ = {};
+  std::vector<int> survivors_ = {};  // previous_pids_ less the exited
+  std::vector<std::vector<Fresh>> fresh_ = {};
+  // Where the counters come from, and each worker's chunk of them.
+  std::unique_ptr<Collector> collector_ = {};
+  std::vector<std::vector<LinuxParser::ProcessStat>> stats_ = {};
+  double collection_time_{0};
+  // Recorded tick directories Refresh() steps through, if replaying.
+  std::vector<std::string> replay_ = {};
+  std::size_t replay_tick_{0};
 };
 
 #endif
\ No newline at end of file
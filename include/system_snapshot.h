@@ -0,0 +1,77 @@
+#ifndef SYSTEM_SNAPSHOT_H
+#define SYSTEM_SNAPSHOT_H
+
+#include <vector>
+
+/*
+ * CpuTimes
+ * Counters of one "cpu" line of /proc/stat,
+ * indexed by LinuxParser::CPUStates.
+ */
+struct CpuTimes {
+  long Total() const;  // guest time is already part of user time
+  long Idle() const;   // idle + iowait
+  long times[10]{};
+};
+
+/*
+ * DiskCounters
+ * Counters of one whole device in /proc/diskstats, since boot.
+ */
+struct DiskCounters {
+  char name[32]{};
+  long reads{0};  // completed
+  long sectors_read{0};
+  long read_ms{0};  // spent on completed reads
+  long writes{0};
+  long sectors_written{0};
+  long write_ms{0};
+  long io_ms{0};  // with any I/O in flight
+};
+
+/*
+ * InterfaceCounters
+ * Counters of one network interface in /proc/net/dev, since it came up.
+ */
+struct InterfaceCounters {
+  char name[16]{};  // IFNAMSIZ
+  long receive_bytes{0};
+  long receive_packets{0};
+  long receive_drops{0};
+  long transmit_bytes{0};
+  long transmit_packets{0};
+  long transmit_drops{0};
+};
+
+/*
+ * SystemSnapshot
+ * System wide values for one refresh.
+ * /proc/stat, /proc/meminfo, /proc/uptime, /proc/diskstats,
+ * /proc/net/dev and /proc/net/snmp are each read once per Refresh();
+ * System, Processor, Disks, Network and the display all read from here.
+ */
+struct SystemSnapshot {
+  void Refresh();
+
+  // /proc/stat
+  CpuTimes cpu;                 // aggregate "cpu" line
+  std::vector<CpuTimes> cores;  // "cpuN" lines, sized once
+  int total_processes{0};
+  int running_processes{0};
+  // /proc/meminfo (kB)
+  float mem_total{0};
+  float mem_free{0};
+  // /proc/uptime
+  long uptime{0};        // seconds
+  long uptime_ticks{0};  // clock ticks, same unit as process start times
+  // /proc/diskstats, whole devices only, in the order listed
+  std::vector<DiskCounters> disks;
+  // /proc/net/dev, interfaces that have moved any bytes, in the order
+  // listed
+  std::vector<InterfaceCounters> interfaces;
+  // /proc/net/snmp, TCP segments since boot
+  long tcp_out_segments{0};
+  long tcp_retransmits{0};
+};
+
+#endif
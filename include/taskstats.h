@@ -0,0 +1,81 @@
+#ifndef TASKSTATS_H
+#define TASKSTATS_H
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "collector.h"
+#include "linux_parser.h"
+
+/*
+ * TaskstatsCollector class
+ * Per-process accounting from the kernel's taskstats generic netlink
+ * family instead of parsing text out of /proc.
+ * Every process takes two requests: by thread group id for CPU time and
+ * delays summed over its threads, and by pid for the start time, parent,
+ * memory high-water marks and I/O, which the kernel only reports per
+ * task. Requests for a batch of processes go out in one sendto(2) and
+ * the replies, queued by the time it returns, come back in one
+ * recvmmsg(2), so a batch costs two syscalls however many processes are
+ * in it.
+ * taskstats has no process state and no count of children's time:
+ * kernel threads are told apart by their parent, kthreadd, and zombies by
+ * having no memory left; cutime and cstime stay 0. The start time is
+ * worked out from how long a process has run, so it may be a tick off
+ * from one query to the next.
+ * Needs CAP_NET_ADMIN and a kernel built with CONFIG_TASKSTATS. Delays
+ * are 0 unless delay accounting is on (kernel.task_delayacct).
+ */
+class TaskstatsCollector : public Collector {
+ public:
+  // One process's accounting, as far as the kernel has it.
+  struct Record {
+    bool found{false};              // both replies arrived
+    std::uint64_t utime{0};         // us, all threads
+    std::uint64_t stime{0};         // us, all threads
+    std::uint64_t cpu_delay{0};     // ns waiting for a CPU, all threads
+    std::uint64_t blkio_delay{0};   // ns waiting for block I/O
+    std::uint64_t begin{0};         // us since boot
+    int parent{0};
+    std::uint64_t hiwater_rss{0};   // KiB
+    std::uint64_t hiwater_vm{0};    // KiB
+    std::uint64_t read_bytes{0};    // of the main thread
+    std::uint64_t write_bytes{0};   // of the main thread
+  };
+
+  // Null if taskstats cannot be used.
+  static std::unique_ptr<TaskstatsCollector> Make(int workers);
+  ~TaskstatsCollector() override;
+
+  const char* Name() const override;
+  long StartTimeSlack() const override;
+  void Stat(const int* pids, std::size_t count,
+            LinuxParser::ProcessStat* stats, int worker) override;
+  void Read(const int* pids, std::size_t count, Record* records,
+            int worker);
+
+ private:
+  // A socket and buffers for one worker.
+  struct Channel {
+    int socket{-1};
+    std::vector<char> requests;
+    std::vector<char> replies;
+    std::vector<mmsghdr> headers;
+    std::vector<iovec> vectors;
+  };
+
+  TaskstatsCollector() = default;
+  void ReadBatch(Channel& channel, const int* pids, std::size_t count,
+                 Record* records);
+
+  int family_{0};  // generic netlink id of taskstats
+  long hertz_{100};
+  std::vector<Channel> channels_;
+  std::vector<Record> records_;  // per worker, kBatch each
+};
+
+#endif
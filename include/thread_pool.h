@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * ThreadPool class
+ * A fixed set of worker threads that stay alive between ticks.
+ * ParallelFor() hands every worker an even share of the chunks; a worker
+ * that runs out of its own steals from the end of another's share. The
+ * calling thread works as worker 0, so a pool of size 1 runs inline.
+ */
+class ThreadPool {
+ public:
+  using Task = std::function<void(std::size_t chunk, int worker)>;
+
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int Size() const;
+  void ParallelFor(std::size_t chunks, const Task& task);
+
+ private:
+  // Chunks [begin, end) not yet taken from one worker's share.
+  struct Share {
+    std::mutex mutex;
+    std::size_t begin{0};
+    std::size_t end{0};
+  };
+  void Work(int worker);
+  void Run(int worker);
+  bool Next(int worker, std::size_t& chunk);
+
+  std::vector<std::unique_ptr<Share>> shares_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  const Task* task_{nullptr};
+  long generation_{0};
+  int busy_{0};
+  bool stop_{false};
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef THREAD_TABLE_H
+#define THREAD_TABLE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process.h"
+#include "system_snapshot.h"
+#include "thread_pool.h"
+
+/*
+ * ThreadTable class
+ * The threads of a few processes, for the drill-down view: one busy
+ * thread among the hundreds of a JVM shows up by name instead of hiding
+ * in its process's total.
+ * Collect() lists /proc/<pid>/task of each process it is given, then
+ * reads the stat of every thread found; both steps are spread over the
+ * thread pool. At most kMaxThreads are read per call, taken from the
+ * processes in the order given, so the cost stays bounded however many
+ * threads the host runs.
+ * CPU is worked out as for processes (see ProcessTable::Update()),
+ * against the thread's counters from the previous Collect(); a thread
+ * not seen then shows no load until the next one.
+ */
+class ThreadTable {
+ public:
+  static const std::size_t kMaxThreads{4096};
+
+  struct Thread {
+    int tid{0};
+    int pid{0};
+    char state{0};
+    char name[LinuxParser::kCommSize]{};
+    long starttime{0};
+    long active{0};  // utime + stime
+    long total{0};   // machine jiffies when it was read
+    float cpu{0};
+    const std::string* command{nullptr};  // of its process
+  };
+
+  void Collect(const std::vector<Process>& processes, ThreadPool& pool,
+               const SystemSnapshot& snapshot);
+  const std::vector<Thread>& Threads() const;  // busiest first
+  std::size_t Skipped() const;  // listed but over kMaxThreads
+
+ private:
+  std::vector<std::vector<int>> tids_;  // per process, as listed
+  std::vector<const std::string*> commands_;  // per process
+  // Threads to read: index into the processes, tid.
+  std::vector<std::pair<std::size_t, int>> tasks_;
+  std::vector<std::vector<Thread>> read_;  // per worker
+  std::vector<Thread> threads_;
+  std::vector<Thread> previous_;  // sorted by tid
+  std::size_t skipped_{0};
+};
+
+#endif
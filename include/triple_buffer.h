@@ -0,0 +1,50 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+ * TripleBuffer class
+ * Hands values from one writer thread to one reader thread without
+ * locks. The writer fills Back() and publishes it; the reader picks up
+ * the latest published value with Update() and reads it at Front().
+ * Neither side ever waits for the other, and a value the reader is
+ * looking at is never written to. Values the reader did not get to in
+ * time are skipped.
+ * The three slots are reused, so a T that keeps its capacity (vectors,
+ * strings) stops allocating once it has grown.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  T& Back() { return slots_[back_]; }
+
+  // Writer: make Back() the latest value and take a free slot.
+  void Publish() {
+    back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) &
+            kSlot;
+  }
+
+  // Reader: move to the latest value, if one was published since.
+  bool Update() {
+    if ((middle_.load(std::memory_order_relaxed) & kFresh) == 0) {
+      return false;
+    }
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kSlot;
+    return true;
+  }
+
+  const T& Front() const { return slots_[front_]; }
+
+ private:
+  // The middle slot's index, and whether it holds an unread value.
+  static const unsigned kSlot{3};
+  static const unsigned kFresh{4};
+
+  T slots_[3];
+  unsigned back_{0};   // writer only
+  std::atomic<unsigned> middle_{1};
+  unsigned front_{2};  // reader only
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * UserCache class
+ * Maps user ids to user names.
+ * The password file is read once and again only after its mtime changes.
+ * Ids it does not list (LDAP, NIS, ...) are asked of getpwuid_r once.
+ * The names are a vector sorted by uid: a host has a few dozen users,
+ * which one binary search over contiguous memory finds faster than
+ * hashing. Name() returns a copy, since a reload replaces them all.
+ * Every member may be called from several threads.
+ */
+class UserCache {
+ public:
+  explicit UserCache(std::string path);
+  std::string Name(int uid);
+  void Revalidate();  // reload when the password file has changed
+  void SetPath(std::string path);  // read another password file
+
+ private:
+  void Load();
+
+  std::mutex mutex_;
+  std::string path_;
+  timespec mtime_{};
+  std::vector<std::pair<int, std::string>> names_;  // by uid
+};
+
+#endif
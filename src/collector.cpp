@@ -0,0 +1,30 @@
+#include <cstddef>
+#include <memory>
+
+#include "collector.h"
+#include "linux_parser.h"
+#include "taskstats.h"
+
+// /proc/<pid>/stat of each process, as the monitor has always read it.
+class ProcfsCollector : public Collector {
+ public:
+  const char* Name() const override { return "procfs"; }
+  void Stat(const int* pids, std::size_t count,
+            LinuxParser::ProcessStat* stats, int) override {
+    for (std::size_t i = 0; i < count; ++i) {
+      if (!LinuxParser::Stat(pids[i], stats[i])) {
+        stats[i].state = 0;
+      }
+    }
+  }
+};
+
+std::unique_ptr<Collector> Collector::Make(Kind kind, int workers) {
+  switch (kind) {
+    case kProcfs:
+      return std::make_unique<ProcfsCollector>();
+    case kTaskstats:
+      return TaskstatsCollector::Make(workers);
+  }
+  return nullptr;
+}
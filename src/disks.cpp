@@ -0,0 +1,37 @@
+#include <algorithm>
+#include <vector>
+
+#include "counter_deltas.h"
+#include "disks.h"
+#include "system_snapshot.h"
+
+using Deltas = CounterDeltas<DiskCounters, DiskLoad>;
+
+// /proc/diskstats counts 512 byte sectors whatever the device uses.
+static const long kSectorSize{512};
+
+// What one disk did between the before and now counters.
+static void Derive(DiskLoad& load, const DiskCounters& now,
+                   const DiskCounters& before, float seconds) {
+  long reads = now.reads - before.reads;
+  long writes = now.writes - before.writes;
+  load.read_rate =
+      Deltas::Rate(now.sectors_read, before.sectors_read, seconds) *
+      kSectorSize;
+  load.write_rate =
+      Deltas::Rate(now.sectors_written, before.sectors_written, seconds) *
+      kSectorSize;
+  load.read_wait = reads > 0 ? (float)(now.read_ms - before.read_ms) / reads
+                             : 0;
+  load.write_wait =
+      writes > 0 ? (float)(now.write_ms - before.write_ms) / writes : 0;
+  load.utilization = std::clamp(
+      (now.io_ms - before.io_ms) / (seconds * 1000), 0.0f, 1.0f);
+}
+
+// Take the device counters from this tick's snapshot.
+void Disks::Update(const SystemSnapshot& snapshot) {
+  deltas_.Update(snapshot.disks, snapshot.uptime_ticks, Derive);
+}
+
+const std::vector<DiskLoad>& Disks::Loads() const { return deltas_.Loads(); }
@@ -0,0 +1,205 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include "exporter.h"
+
+using std::string_view;
+
+// Written out once this much has piled up.
+static const std::size_t kBufferSize{64 * 1024};
+// Longest field other than a string: a number in either format.
+static const std::size_t kNumberSize{32};
+
+static const char kCsvHeader[] =
+    "type,time_ms,cpu,user,system,iowait,steal,memory,processes,running,"
+    "uptime,cpu_time,pid,user_name,ram_kb,command\n";
+
+Exporter::Exporter(int fd, Format format)
+    : fd_(fd), format_(format), buffer_(kBufferSize + kNumberSize) {
+  if (format_ == kCsv) {
+    Raw(kCsvHeader);
+  }
+}
+
+// One sample: the system and then every process given. False if it
+// could not all be written.
+bool Exporter::Write(std::chrono::system_clock::time_point time,
+                     System& system, const std::vector<Process>& processes) {
+  long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                time.time_since_epoch())
+                .count();
+  WriteSystem(system, ms);
+  for (const Process& process : processes) {
+    WriteProcess(process, ms);
+  }
+  return Flush();
+}
+
+void Exporter::WriteSystem(System& system, long time) {
+  const CpuLoad& load = system.Cpu().Load();
+  first_field_ = true;
+  Raw(format_ == kJson ? "{" : "");
+  Field("type");
+  Text("system");
+  Field("time_ms");
+  Number(time);
+  Field("cpu");
+  Number((double)load.utilization);
+  Field("user");
+  Number((double)load.user);
+  Field("system");
+  Number((double)load.system);
+  Field("iowait");
+  Number((double)load.iowait);
+  Field("steal");
+  Number((double)load.steal);
+  Field("memory");
+  Number((double)system.MemoryUtilization());
+  Field("processes");
+  Number((long)system.TotalProcesses());
+  Field("running");
+  Number((long)system.RunningProcesses());
+  Field("uptime");
+  Number(system.UpTime());
+  Raw(format_ == kJson ? "}\n" : ",,,,,\n");
+}
+
+void Exporter::WriteProcess(const Process& process, long time) {
+  first_field_ = true;
+  Raw(format_ == kJson ? "{" : "");
+  Field("type");
+  Text("process");
+  Field("time_ms");
+  Number(time);
+  Field("cpu");
+  Number((double)process.CpuUtilization());
+  if (format_ == kCsv) {
+    Raw(",,,,,,,,");
+  }
+  // CPU seconds, children included; not the age of the process.
+  Field("cpu_time");
+  Number(process.UpTime());
+  Field("pid");
+  Number((long)process.Pid());
+  Field("user_name");
+  Text(process.User());
+  Field("ram_kb");
+  Number(process.Ram());
+  Field("command");
+  Text(process.Command());
+  Raw(format_ == kJson ? "}\n" : "\n");
+}
+
+// Separate this field from the previous one; JSON also names it.
+void Exporter::Field(string_view name) {
+  if (!first_field_) {
+    Raw(",");
+  }
+  first_field_ = false;
+  if (format_ == kJson) {
+    Raw("\"");
+    Raw(name);
+    Raw("\":");
+  }
+}
+
+// A string value. JSON escapes quotes, backslashes and control
+// characters; CSV doubles quotes. Runs of plain characters are copied
+// whole.
+void Exporter::Text(string_view text) {
+  static const char kHex[] = "0123456789abcdef";
+  Raw("\"");
+  auto special = [this](unsigned char c) {
+    return c == '"' || (format_ == kJson && (c == '\\' || c < 0x20));
+  };
+  while (!text.empty()) {
+    size_t plain = std::find_if(text.begin(), text.end(), special) -
+                   text.begin();
+    Raw(text.substr(0, plain));
+    if (plain == text.size()) {
+      break;
+    }
+    unsigned char c = text[plain];
+    if (c == '"') {
+      Raw(format_ == kJson ? "\\\"" : "\"\"");
+    } else if (c == '\\') {
+      Raw("\\\\");
+    } else {
+      char control[] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf]};
+      Raw(string_view(control, sizeof(control)));
+    }
+    text.remove_prefix(plain + 1);
+  }
+  Raw("\"");
+}
+
+void Exporter::Raw(string_view text) {
+  while (!text.empty()) {
+    if (size_ >= kBufferSize) {
+      Flush();
+    }
+    size_t count = std::min(text.size(), kBufferSize - size_);
+    std::copy_n(text.data(), count, buffer_.data() + size_);
+    size_ += count;
+    text.remove_prefix(count);
+  }
+}
+
+// Numbers are written straight into the spare room past kBufferSize.
+void Exporter::Number(long value) {
+  if (size_ >= kBufferSize) {
+    Flush();
+  }
+  char* end = buffer_.data() + buffer_.size();
+  size_ = std::to_chars(buffer_.data() + size_, end, value).ptr -
+          buffer_.data();
+}
+
+// Four decimals, as a fixed point integer: shares and fractions need no
+// more, and this is several times faster than formatting the double.
+void Exporter::Number(double value) {
+  long scaled = std::lround(value * 10000);
+  if (scaled < 0) {
+    Raw("-");
+    scaled = -scaled;
+  }
+  Number(scaled / 10000);
+  char fraction[5] = {'.'};
+  long digits = scaled % 10000;
+  for (int i = 4; i > 0; --i) {
+    fraction[i] = '0' + digits % 10;
+    digits /= 10;
+  }
+  Raw(string_view(fraction, sizeof(fraction)));
+}
+
+// Hand the buffer to write(2); a short write is continued. After a
+// failed write the buffer is dropped and so is everything after it, so
+// the output never goes on past a gap.
+bool Exporter::Flush() {
+  const char* data = buffer_.data();
+  size_t left = failed_ ? 0 : size_;
+  size_ = 0;
+  while (left > 0) {
+    ssize_t written = write(fd_, data, left);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      if (written == 0) {
+        errno = EIO;
+      }
+      failed_ = true;
+      break;
+    }
+    data += written;
+    left -= written;
+  }
+  return !failed_;
+}
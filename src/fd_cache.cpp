@@ -0,0 +1,198 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+#include "fd_cache.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+using std::size_t;
+using std::string_view;
+
+// Descriptors left for everything else the monitor opens.
+static const size_t kReservedFds{64};
+// Processes held at most, however high the descriptor limit.
+static const size_t kMaxProcesses{32768};
+
+static const char* const kFilenames[FdCache::kFiles] = {"/stat", "/status"};
+
+static void Close(int (&fds)[FdCache::kFiles]) {
+  for (int& fd : fds) {
+    if (fd >= 0) {
+      ProcReader::Close(fd);
+      fd = -1;
+    }
+  }
+}
+
+FdCache::FdCache(size_t capacity) {
+  for (Shard& shard : shards_) {
+    shard.capacity = std::max<size_t>(capacity / kShards, 1);
+    // At least twice as many slots, a power of two.
+    int bits{1};
+    while ((size_t{1} << bits) < 2 * shard.capacity) {
+      ++bits;
+    }
+    shard.shift = 32 - bits;
+    shard.slots.resize(size_t{1} << bits);
+  }
+}
+
+FdCache::~FdCache() {
+  for (Shard& shard : shards_) {
+    for (Entry& entry : shard.slots) {
+      Close(entry.fds);
+    }
+  }
+}
+
+// Processes that fit under the descriptor limit, two files each, after
+// raising the soft limit as far as the hard one allows. Capped so that
+// the tables stay small when the limit is huge.
+size_t FdCache::DefaultCapacity() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+    return kShards;
+  }
+  if (limit.rlim_cur < limit.rlim_max) {
+    rlim_t soft = limit.rlim_cur;
+    limit.rlim_cur = limit.rlim_max;
+    if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+      limit.rlim_cur = soft;
+    }
+  }
+  if (limit.rlim_cur == RLIM_INFINITY) {
+    return kMaxProcesses;
+  }
+  if (limit.rlim_cur <= 2 * kReservedFds) {
+    return kShards;
+  }
+  return std::min<size_t>((limit.rlim_cur - kReservedFds) / kFiles,
+                          kMaxProcesses);
+}
+
+// Processes that currently have descriptors open.
+size_t FdCache::Size() const {
+  size_t size{0};
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    size += shard.size;
+  }
+  return size;
+}
+
+FdCache::Shard& FdCache::ShardOf(int pid) { return shards_[pid % kShards]; }
+
+// First slot to probe for pid. Pids within a shard are kShards apart, so
+// they are spread by a multiplicative hash rather than taken as they are.
+size_t FdCache::Shard::Home(int pid) const {
+  return (static_cast<uint32_t>(pid / kShards) * 2654435769u) >> shift;
+}
+
+FdCache::Entry* FdCache::Shard::Find(int pid) {
+  size_t mask = slots.size() - 1;
+  for (size_t slot = Home(pid);; slot = (slot + 1) & mask) {
+    if (slots[slot].pid == pid) {
+      return &slots[slot];
+    }
+    if (slots[slot].pid < 0) {
+      return nullptr;
+    }
+  }
+}
+
+FdCache::Entry* FdCache::Shard::Insert(int pid) {
+  if (size >= capacity) {
+    return nullptr;
+  }
+  size_t mask = slots.size() - 1;
+  size_t slot = Home(pid);
+  while (slots[slot].pid >= 0) {
+    slot = (slot + 1) & mask;
+  }
+  ++size;
+  slots[slot].pid = pid;
+  return &slots[slot];
+}
+
+// Close and drop pid's entry, then move later entries of the same probe
+// run back into the gap, so that lookups need no tombstones.
+void FdCache::Shard::Erase(int pid) {
+  Entry* entry = Find(pid);
+  if (entry == nullptr) {
+    return;
+  }
+  Close(entry->fds);
+  entry->pid = -1;
+  --size;
+  size_t mask = slots.size() - 1;
+  size_t gap = entry - slots.data();
+  for (size_t slot = (gap + 1) & mask; slots[slot].pid >= 0;
+       slot = (slot + 1) & mask) {
+    size_t home = Home(slots[slot].pid);
+    // Movable unless its home lies cyclically in (gap, slot].
+    if (((slot - home) & mask) >= ((slot - gap) & mask)) {
+      slots[gap] = slots[slot];
+      slots[slot] = Entry{};
+      gap = slot;
+    }
+  }
+}
+
+// Close every descriptor, e.g. when the proc root changes.
+void FdCache::Clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (Entry& entry : shard.slots) {
+      Close(entry.fds);
+      entry.pid = -1;
+    }
+    shard.size = 0;
+  }
+}
+
+// Close the descriptors of pid, e.g. after it exited.
+void FdCache::Forget(int pid) {
+  Shard& shard = ShardOf(pid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  shard.Erase(pid);
+}
+
+// Read /proc/<pid>/<file> through a kept descriptor.
+// An empty view means the process is gone.
+string_view FdCache::Read(int pid, File file) {
+  Shard& shard = ShardOf(pid);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  // The second attempt opens afresh: the pid may already belong to a
+  // new process that the stale descriptor can not see.
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    Entry* entry = shard.Find(pid);
+    if (entry == nullptr) {
+      entry = shard.Insert(pid);
+    }
+    if (entry == nullptr) {
+      return ProcReader::ReadPid(pid, kFilenames[file]);  // full
+    }
+    int& fd = entry->fds[file];
+    if (fd < 0) {
+      char path[PATH_MAX];
+      snprintf(path, sizeof(path), "%s%d%s",
+               LinuxParser::ProcDirectory().c_str(), pid, kFilenames[file]);
+      fd = ProcReader::Open(path, O_RDONLY);
+      if (fd < 0) {
+        shard.Erase(pid);
+        return {};
+      }
+    }
+    string_view text = ProcReader::ReadFd(fd);
+    if (!text.empty()) {
+      return text;
+    }
+    shard.Erase(pid);
+  }
+  return {};
+}
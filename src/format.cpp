@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <string>
 
 #include "format.h"
@@ -8,29 +9,39 @@ using std::string;
 // INPUT: Long int measuring seconds
 // OUTPUT: HH:MM:SS
 string Format::ElapsedTime(long seconds) {
-  // truncated minutes from seconds.
+  char buffer[32];
+  return ElapsedTime(seconds, buffer, sizeof(buffer));
+}
+
+// Hours are not wrapped at a day; pads each part to two digits.
+const char* Format::ElapsedTime(long seconds, char* buffer, std::size_t size) {
   long minutes = seconds / 60;
-  // remaining seconds from integer division.
-  long remainder_seconds = seconds % 60;
-  // truncated hours from minutes
   long hours = minutes / 60;
-  // remaining minutes from modulo.
-  minutes = minutes % 60;
+  snprintf(buffer, size, "%02ld:%02ld:%02ld", hours, minutes % 60,
+           seconds % 60);
+  return buffer;
+}
 
-  // convert each component to a string.
-  // if 1 digit, pad with leading zero.
-  std::string str_hours = std::to_string(hours);
-  if (str_hours.length() < 2) {
-    str_hours = "0" + str_hours;
+// Powers of 1024, with one decimal below 100 of a unit.
+const char* Format::Bytes(double bytes, char* buffer, std::size_t size) {
+  static const char units[] = "KMGTP";
+  if (bytes < 0) {
+    snprintf(buffer, size, "-");
+    return buffer;
   }
-  std::string str_minutes = std::to_string(minutes);
-  if (str_minutes.length() < 2) {
-    str_minutes = "0" + str_minutes;
+  if (bytes < 1024) {
+    snprintf(buffer, size, "%.0f", bytes);
+    return buffer;
   }
-  std::string str_seconds = std::to_string(remainder_seconds);
-  if (str_seconds.length() < 2) {
-    str_seconds = "0" + str_seconds;
+  int unit{-1};
+  while (bytes >= 1024 && unit + 1 < (int)sizeof(units) - 1) {
+    bytes /= 1024;
+    ++unit;
   }
-
-  return str_hours + ":" + str_minutes + ":" + str_seconds;
-}
\ No newline at end of file
+  if (bytes < 99.95) {
+    snprintf(buffer, size, "%.1f%c", bytes, units[unit]);
+  } else {
+    snprintf(buffer, size, "%.0f%c", bytes, units[unit]);
+  }
+  return buffer;
+}
@@ -0,0 +1,89 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "history.h"
+#include "process.h"
+#include "system.h"
+
+// Copy the system values and the count highest ranked processes, and
+// with with_threads the count busiest threads System::CollectThreads() read.
+// System::Processes() must have run for this tick; it is not run again.
+void Frame::Capture(System& system, const History& history,
+                    std::size_t count, bool with_threads) {
+  os = system.OperatingSystem();
+  kernel = system.Kernel();
+  cpu = system.Cpu().Load();
+  cores = system.Cpu().Cores();
+  memory = system.MemoryUtilization();
+  disks = system.DiskLoads();
+  interfaces = system.Net().Loads();
+  retransmit_rate = system.Net().RetransmitRate();
+  retransmit_share = system.Net().RetransmitShare();
+  cpu_range = history.Range(History::kCpu, kSpan);
+  memory_range = history.Range(History::kMemory, kSpan);
+  history.Trail(History::kCpu, cpu_trail, kTrail);
+  history.Trail(History::kMemory, memory_trail, kTrail);
+  total_processes = system.TotalProcesses();
+  running_processes = system.RunningProcesses();
+  uptime = system.UpTime();
+  started = system.Started();
+  exited = system.Exited();
+  short_lived = system.ShortLived();
+  opens_per_tick = system.OpensPerTick();
+  collection_time = system.CollectionTime();
+  threads = system.Threads();
+  collector = system.CollectorName();
+  sort = system.SortColumn();
+  processes = system.Visible();
+
+  const std::vector<Process>& top = system.Top(count);
+  rows.resize(top.size());
+  for (std::size_t i = 0; i < top.size(); ++i) {
+    const Process& process = top[i];
+    Row& row = rows[i];
+    row.pid = process.Pid();
+    std::string user = process.User();
+    std::size_t length = std::min(user.size(), sizeof(row.user) - 1);
+    std::copy_n(user.data(), length, row.user);
+    row.user[length] = '\0';
+    row.cpu = process.CpuUtilization();
+    row.ram = process.Ram();
+    row.read_rate = process.ReadRate();
+    row.write_rate = process.WriteRate();
+    row.uptime = process.UpTime();
+    row.command = process.Command();
+    History::Summary range =
+        history.Range(row.pid, process.StartTime(), kSpan);
+    row.average = range.samples > 0 ? range.average : NAN;
+    history.Trail(row.pid, process.StartTime(), row.trail, kRowTrail);
+  }
+
+  thread_count = 0;
+  threads_skipped = 0;
+  thread_rows.clear();
+  if (!with_threads) {
+    return;
+  }
+  const ThreadTable& table = system.TopThreads();
+  const std::vector<ThreadTable::Thread>& read = table.Threads();
+  thread_count = read.size();
+  threads_skipped = table.Skipped();
+  long hertz = sysconf(_SC_CLK_TCK);
+  thread_rows.resize(std::min(count, read.size()));
+  for (std::size_t i = 0; i < thread_rows.size(); ++i) {
+    const ThreadTable::Thread& thread = read[i];
+    ThreadRow& row = thread_rows[i];
+    row.tid = thread.tid;
+    row.pid = thread.pid;
+    row.state = thread.state;
+    row.cpu = thread.cpu;
+    row.time = thread.active / hertz;
+    std::copy_n(thread.name, sizeof(row.name), row.name);
+    row.command = *thread.command;
+  }
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "history.h"
+#include "process.h"
+#include "system.h"
+
+using std::size_t;
+using std::uint64_t;
+
+static const float kMissing = std::numeric_limits<float>::quiet_NaN();
+
+// As many ticks as the budget holds, at least one.
+History::History(size_t budget, size_t processes)
+    : capacity_(std::max<size_t>(
+          1, budget / (sizeof(std::int64_t) +
+                       (kSeries + processes) * sizeof(float)))),
+      time_(capacity_),
+      system_(kSeries * capacity_, kMissing),
+      slots_(processes),
+      newcomers_(processes),
+      processes_(processes * capacity_, kMissing) {}
+
+size_t History::Capacity() const { return capacity_; }
+
+size_t History::Size() const { return std::min<uint64_t>(ticks_, capacity_); }
+
+size_t History::Bytes() const {
+  return time_.size() * sizeof(time_[0]) +
+         (system_.size() + processes_.size()) * sizeof(float);
+}
+
+// Store this tick over the oldest one once the ring is full.
+void History::Record(Clock::time_point time, System& system) {
+  size_t at = ticks_ % capacity_;
+  time_[at] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                  time.time_since_epoch())
+                  .count();
+  system_[kCpu * capacity_ + at] = system.Cpu().Load().utilization;
+  system_[kMemory * capacity_ + at] = system.MemoryUtilization();
+  for (size_t slot = 0; slot < slots_.size(); ++slot) {
+    processes_[slot * capacity_ + at] = kMissing;
+  }
+  // Processes recorded before keep their slots; only then do newcomers
+  // take the slots idle the longest, so none takes one still in use.
+  const std::vector<Process>& top =
+      system.Top(slots_.size(), ProcessTable::kCpu);
+  size_t newcomers{0};
+  for (size_t i = 0; i < top.size(); ++i) {
+    long slot = Find(top[i].Pid(), top[i].StartTime());
+    if (slot < 0) {
+      newcomers_[newcomers++] = i;
+      continue;
+    }
+    slots_[slot].last = ticks_ + 1;
+    processes_[slot * capacity_ + at] = top[i].CpuUtilization();
+  }
+  for (size_t i = 0; i < newcomers; ++i) {
+    const Process& process = top[newcomers_[i]];
+    // There are as many slots as processes a tick records, so one not
+    // used this tick is left.
+    auto oldest = std::min_element(
+        slots_.begin(), slots_.end(),
+        [](const Slot& a, const Slot& b) { return a.last < b.last; });
+    *oldest = {process.Pid(), process.StartTime(), ticks_, ticks_ + 1};
+    processes_[(oldest - slots_.begin()) * capacity_ + at] =
+        process.CpuUtilization();
+  }
+  ++ticks_;
+}
+
+History::Summary History::Range(Series series,
+                                std::chrono::milliseconds span) const {
+  size_t count = Ticks(0, span);
+  return Summarize(&system_[series * capacity_], count);
+}
+
+// CPU utilization of one process; a process never recorded has no values.
+History::Summary History::Range(int pid, long starttime,
+                                std::chrono::milliseconds span) const {
+  long slot = Find(pid, starttime);
+  if (slot < 0) {
+    return {};
+  }
+  size_t count = Ticks(slots_[slot].since, span);
+  return Summarize(&processes_[slot * capacity_], count);
+}
+
+void History::Trail(Series series, float* values, size_t count) const {
+  Copy(&system_[series * capacity_], 0, values, count);
+}
+
+void History::Trail(int pid, long starttime, float* values,
+                    size_t count) const {
+  long slot = Find(pid, starttime);
+  if (slot < 0) {
+    std::fill(values, values + count, kMissing);
+    return;
+  }
+  Copy(&processes_[slot * capacity_], slots_[slot].since, values, count);
+}
+
+// Slot of a process, -1 if it has none. Slots are few, so a linear
+// search beats a map and needs no allocation.
+long History::Find(int pid, long starttime) const {
+  for (size_t slot = 0; slot < slots_.size(); ++slot) {
+    if (slots_[slot].pid == pid && slots_[slot].starttime == starttime) {
+      return slot;
+    }
+  }
+  return -1;
+}
+
+// Number of the newest ticks, none before since, that lie within span of
+// the newest one.
+size_t History::Ticks(uint64_t since, std::chrono::milliseconds span) const {
+  if (ticks_ == 0) {
+    return 0;
+  }
+  uint64_t first = std::max<uint64_t>(since, ticks_ - Size());
+  std::int64_t newest = time_[(ticks_ - 1) % capacity_];
+  uint64_t tick = ticks_;
+  while (tick > first &&
+         newest - time_[(tick - 1) % capacity_] < span.count()) {
+    --tick;
+  }
+  return ticks_ - tick;
+}
+
+// Fold the newest count values of a column; NaN ones are left out.
+History::Summary History::Summarize(const float* column, size_t count) const {
+  Summary summary;
+  summary.min = std::numeric_limits<float>::max();
+  summary.max = std::numeric_limits<float>::lowest();
+  double total{0};
+  auto fold = [&](const float* value, const float* end) {
+    for (; value < end; ++value) {
+      if (std::isnan(*value)) {
+        continue;
+      }
+      summary.min = std::min(summary.min, *value);
+      summary.max = std::max(summary.max, *value);
+      total += *value;
+      ++summary.samples;
+    }
+  };
+  // The range is at most two runs of the ring: up to its end, then on
+  // from its start.
+  size_t begin = (ticks_ - count) % capacity_;
+  size_t run = std::min(count, capacity_ - begin);
+  fold(column + begin, column + begin + run);
+  fold(column, column + count - run);
+  if (summary.samples == 0) {
+    return {};
+  }
+  summary.average = total / summary.samples;
+  return summary;
+}
+
+// The newest count values of a column, oldest first, padded in front
+// with NaN where the ring holds nothing from since on.
+void History::Copy(const float* column, uint64_t since, float* values,
+                   size_t count) const {
+  uint64_t first = std::max<uint64_t>(since, ticks_ - Size());
+  size_t held = std::min<uint64_t>(count, ticks_ - first);
+  std::fill(values, values + count - held, kMissing);
+  for (size_t i = 0; i < held; ++i) {
+    values[count - held + i] = column[(ticks_ - held + i) % capacity_];
+  }
+}
@@ -1,91 +1,208 @@
 #include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
 #include <unistd.h>
-#include <iostream>
+#include <algorithm>
+#include <cstdio>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "fd_cache.h"
 #include "linux_parser.h"
+#include "proc_reader.h"
+#include "user_cache.h"
 
-using std::stof;
+using ProcReader::NextLine;
+using ProcReader::NextToken;
+using ProcReader::ParseLong;
+using ProcReader::SkipTokens;
 using std::string;
-using std::to_string;
+using std::string_view;
 using std::vector;
 
+// Paths under the current root, built once per SetRoot().
+struct Paths {
+  explicit Paths(const string& root_path) {
+    using namespace LinuxParser;
+    root = root_path;
+    proc = root + kProcDirectory;
+    files[kStatFile] = proc + kStatFilename;
+    files[kMeminfoFile] = proc + kMeminfoFilename;
+    files[kUptimeFile] = proc + kUptimeFilename;
+    files[kVersionFile] = proc + kVersionFilename;
+    files[kOSFile] = root + kOSPath;
+    files[kPasswordFile] = root + kPasswordPath;
+    files[kDiskstatsFile] = proc + kDiskstatsFilename;
+    files[kNetDevFile] = proc + kNetDevFilename;
+    files[kSnmpFile] = proc + kSnmpFilename;
+  }
+  string root;
+  string proc;
+  string files[LinuxParser::kSystemFiles];
+};
+
+static Paths& Resolved() {
+  static Paths paths("");
+  return paths;
+}
+
+// User names by uid, shared by every process.
+static UserCache users(LinuxParser::Path(LinuxParser::kPasswordFile));
+
+// stat and status descriptors of the processes we follow.
+static FdCache descriptors;
+
+// Switch to another root. Must not run while processes are collected.
+// Kept descriptors belong to the old root and are closed. Without
+// reload_users the user names read so far stay, as when stepping
+// through the ticks of one recording.
+void LinuxParser::SetRoot(const string& root, bool reload_users) {
+  Resolved() = Paths(root);
+  descriptors.Clear();
+  if (reload_users) {
+    users.SetPath(Path(kPasswordFile));
+  }
+}
+
+const string& LinuxParser::Root() { return Resolved().root; }
+
+const string& LinuxParser::ProcDirectory() { return Resolved().proc; }
+
+const string& LinuxParser::Path(SystemFile file) {
+  return Resolved().files[file];
+}
+
+long LinuxParser::FileOpens() { return ProcReader::Opens(); }
+
+// Counters of the aggregate "cpu" line of /proc/stat.
+static void AggregateCpu(long (&times)[10]) {
+  const string& path = LinuxParser::Path(LinuxParser::kStatFile);
+  string_view stat = ProcReader::Read(path.c_str());
+  string_view line = NextLine(stat);
+  if (NextToken(line) != "cpu") {
+    return;
+  }
+  for (long& time : times) {
+    time = ParseLong(NextToken(line));
+  }
+}
+
+// Value of a "key value" line of /proc/stat, 0 if there is none.
+static long StatValue(string_view key) {
+  const string& path = LinuxParser::Path(LinuxParser::kStatFile);
+  string_view stat = ProcReader::Read(path.c_str());
+  string_view value = ProcReader::Value(stat, key);
+  return ParseLong(NextToken(value));
+}
+
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::OperatingSystem() {
-  string line;
-  string key;
-  string value;
-  std::ifstream filestream(kOSPath);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::replace(line.begin(), line.end(), ' ', '_');
-      std::replace(line.begin(), line.end(), '=', ' ');
-      std::replace(line.begin(), line.end(), '"', ' ');
-      std::istringstream linestream(line);
-      while (linestream >> key >> value) {
-        if (key == "PRETTY_NAME") {
-          std::replace(value.begin(), value.end(), '_', ' ');
-          return value;
-        }
-      }
-    }
+  string_view os_release = ProcReader::Read(Path(kOSFile).c_str());
+  string_view value = ProcReader::Value(os_release, "PRETTY_NAME=");
+  // strip the quotes around the name.
+  if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+    value = value.substr(1, value.size() - 2);
   }
-  return value;
+  return string(value);
 }
 
 // DONE: An example of how to read data from the filesystem
 string LinuxParser::Kernel() {
-  string os, kernel, version;
-  string line;
-  std::ifstream stream(kProcDirectory + kVersionFilename);
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    linestream >> os >> version >> kernel;
-  }
-  return kernel;
+  string_view version = ProcReader::Read(Path(kVersionFile).c_str());
+  // "Linux version <kernel> ..."
+  SkipTokens(version, 2);
+  return string(NextToken(version));
 }
 
 // BONUS: Update this to use std::filesystem
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    // Is this a directory?
-    if (file->d_type == DT_DIR) {
+  Pids(pids);
+  return pids;
+}
+
+// Layout of the records getdents64 fills in.
+struct linux_dirent64 {
+  ino64_t d_ino;
+  off64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+// Fill numbers with the numeric subdirectories of directory.
+// Reads the directory with getdents64 into a buffer kept per thread and
+// parses names in place; numbers keeps its capacity from call to call.
+// File systems that leave d_type DT_UNKNOWN cost an fstatat() per
+// numeric entry.
+static void Numbers(const char* directory, vector<int>& numbers) {
+  thread_local std::vector<char> buffer(256 * 1024);
+  numbers.clear();
+  int fd = ProcReader::Open(directory, O_RDONLY | O_DIRECTORY);
+  if (fd < 0) {
+    return;
+  }
+  long count;
+  while ((count = ProcReader::ReadDirectory(fd, buffer.data(),
+                                            buffer.size())) > 0) {
+    for (long offset = 0; offset < count;) {
+      auto* file = reinterpret_cast<linux_dirent64*>(buffer.data() + offset);
+      offset += file->d_reclen;
+      if (file->d_type != DT_DIR && file->d_type != DT_UNKNOWN) {
+        continue;
+      }
       // Is every character of the name a digit?
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
-        pids.push_back(pid);
+      int number{0};
+      const char* digit = file->d_name;
+      for (; *digit >= '0' && *digit <= '9'; ++digit) {
+        number = number * 10 + (*digit - '0');
+      }
+      if (*digit != '\0' || digit == file->d_name) {
+        continue;
+      }
+      // Is this a directory?
+      if (file->d_type == DT_UNKNOWN) {
+        struct stat info;
+        ProcReader::CountSyscalls(1);
+        if (fstatat(fd, file->d_name, &info, 0) != 0 ||
+            !S_ISDIR(info.st_mode)) {
+          continue;
+        }
       }
+      numbers.push_back(number);
     }
   }
-  closedir(directory);
-  return pids;
+  ProcReader::Close(fd);
+}
+
+// Fill pids with the numeric directories of /proc.
+// /proc lists pids in ascending order, sorted only checks that it did.
+void LinuxParser::Pids(vector<int>& pids, bool sorted) {
+  Numbers(ProcDirectory().c_str(), pids);
+  if (sorted && !std::is_sorted(pids.begin(), pids.end())) {
+    std::sort(pids.begin(), pids.end());
+  }
+}
+
+// Fill tids with the threads of pid, from /proc/[PID]/task; empty if
+// the process has gone away.
+void LinuxParser::Tasks(int pid, vector<int>& tids) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s%d/task", ProcDirectory().c_str(), pid);
+  Numbers(path, tids);
 }
 
 // Done: Read and return the system memory utilization
 float LinuxParser::MemoryUtilization() {
-  string line;
-  string key;
-  float memFree, memTotal;
-  string value;
-  std::ifstream filestream(kProcDirectory + kMeminfoFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      while (linestream >> key >> value) {
-        if (key == "MemTotal:") {
-          memTotal = std::stof(value);
-        }
-        if (key == "MemFree:") {
-          memFree = std::stof(value);
-        }
-      }
-    }
+  string_view meminfo = ProcReader::Read(Path(kMeminfoFile).c_str());
+  string_view total = ProcReader::Value(meminfo, "MemTotal:");
+  string_view free = ProcReader::Value(meminfo, "MemFree:");
+  float memTotal = ParseLong(NextToken(total));
+  float memFree = ParseLong(NextToken(free));
+  if (memTotal == 0) {
+    return 0.0;
   }
   // Return as a percentage
   // Based on HTOP method. Total used memory = MemTotal - MemFree
@@ -95,42 +212,18 @@ float LinuxParser::MemoryUtilization() {
 
 // Done: Read and return the system uptime
 long LinuxParser::UpTime() {
-  string line;
-  string uptime_s, idletime;
-  long uptime;
-  std::ifstream filestream(kProcDirectory + kUptimeFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      linestream >> uptime_s >> idletime;
-      uptime = std::stol(uptime_s);
-    }
-  }
-  return uptime;
+  string_view uptime = ProcReader::Read(Path(kUptimeFile).c_str());
+  return ParseLong(NextToken(uptime));
 }
 
 // Done: Read and return the number of jiffies for the system
 long LinuxParser::Jiffies() {
-  string line;
-  string key;
-  long user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice;
-  long totalJiff;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      // Read every line from /proc/stat, match on key = "cpu"
-      while (linestream >> key >> user >> nice >> system >> idle >> iowait >>
-             irq >> softirq >> steal >> guest >> guest_nice) {
-        if (key == "cpu") {
-          totalJiff = user + nice + system + idle + iowait + irq + softirq +
-                      steal + guest + guest_nice;
-          break;
-        }
-      }
-    }
+  long times[10]{};
+  AggregateCpu(times);
+  long totalJiff{0};
+  for (long time : times) {
+    totalJiff += time;
   }
-
   return totalJiff;
 }
 
@@ -153,35 +246,17 @@ float LinuxParser::CpuUtilization(int pid) {
 
    */
 
-  long uptime = LinuxParser::UpTime();
+  ProcessStat stat;
+  Stat(pid, stat);
+  return CpuUtilization(stat, LinuxParser::UpTime());
+}
+
+// CPU utilization over the lifetime of a process, from counters
+// already read out of /proc/[PID]/stat.
+float LinuxParser::CpuUtilization(const ProcessStat& stat, long uptime) {
   int hertz = sysconf(_SC_CLK_TCK);
-  long total_time;
-  string skip;
-  long utime{0}, stime{0}, cutime{0}, cstime{0}, starttime{0};
-  string line;
-  string userName;
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       "/stat");
-  while (std::getline(stream, line)) {
-    std::istringstream linestream(line);
-    // Skip past executable name - it may contain a space, but always ends with
-    // ')'
-    linestream.ignore(256, ')');
-    // skip next 11 columns.
-    for (int i = 0; i < 11; i++) {
-      linestream >> skip;
-    }
-    // starting at column 14.
-    linestream >> utime >> stime >> cutime >> cstime;
-    // skip to column 22.
-    for (int i = 0; i < 4; i++) {
-      linestream >> skip;
-    }
-    linestream >> starttime;
-    ;
-  }
-  total_time = utime + stime + cutime + cstime;
-  long seconds = uptime - (starttime / hertz);
+  long total_time = stat.utime + stat.stime + stat.cutime + stat.cstime;
+  long seconds = uptime - (stat.starttime / hertz);
   // don't do division by zero... assume 100% cpu.
   if (seconds == 0) {
     return 1.0;
@@ -191,78 +266,89 @@ float LinuxParser::CpuUtilization(int pid) {
   }
 }
 
+// Parse the counters of a stat line; name receives the comm field, cut
+// short to fit. False if the line is not one.
+static bool ParseStat(string_view line, LinuxParser::ProcessStat& stat,
+                      char* name, size_t size) {
+  stat = LinuxParser::ProcessStat{};
+  // Skip past executable name - it may contain spaces and ')',
+  // but the last ')' always ends it.
+  size_t name_begin = line.find('(');
+  size_t name_end = line.rfind(')');
+  if (name_begin == string_view::npos || name_end == string_view::npos ||
+      name_end < name_begin) {
+    return false;
+  }
+  if (name != nullptr) {
+    size_t length = std::min(name_end - name_begin - 1, size - 1);
+    std::copy_n(line.data() + name_begin + 1, length, name);
+    name[length] = '\0';
+  }
+  line.remove_prefix(name_end + 1);
+  // column 3.
+  string_view state = NextToken(line);
+  stat.state = state.empty() ? 0 : state.front();
+  // skip to column 9.
+  SkipTokens(line, 5);
+  stat.flags = ParseLong(NextToken(line));
+  // skip columns 10 to 13.
+  SkipTokens(line, 4);
+  // starting at column 14.
+  stat.utime = ParseLong(NextToken(line));
+  stat.stime = ParseLong(NextToken(line));
+  stat.cutime = ParseLong(NextToken(line));
+  stat.cstime = ParseLong(NextToken(line));
+  // skip to column 22.
+  SkipTokens(line, 4);
+  stat.starttime = ParseLong(NextToken(line));
+  return true;
+}
+
+// Read the counters of /proc/[PID]/stat in one pass.
+// Returns false when the process has gone away.
+bool LinuxParser::Stat(int pid, ProcessStat& stat) {
+  return ParseStat(descriptors.Read(pid, FdCache::kStat), stat, nullptr, 0);
+}
+
+// The same for one thread, from /proc/[PID]/task/[TID]/stat, along with
+// its name. Threads come and go too fast to keep descriptors for them.
+bool LinuxParser::TaskStat(int pid, int tid, ProcessStat& stat,
+                           char (&name)[kCommSize]) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s%d/task/%d/stat", ProcDirectory().c_str(),
+           pid, tid);
+  return ParseStat(ProcReader::Read(path), stat, name, sizeof(name));
+}
+
+// Kernel threads have no command line and no user space memory.
+bool LinuxParser::IsKernelThread(const ProcessStat& stat) {
+  return stat.flags & kPfKthread;
+}
+
 /*
     Read and return the number of active jiffies for a PID
       use /proc/<pid>/stat
       select utime and stime columns.
 */
 long LinuxParser::ActiveJiffies(int pid) {
-  string skip;
-  long utime{0}, stime{0}, cutime{0}, cstime{0};
-  string line;
-  string userName;
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       "/stat");
-  while (std::getline(stream, line)) {
-    std::istringstream linestream(line);
-    // skip over the first 2 columns - the executable may have a space
-    // which will throw out the istringstream parser.
-    linestream.ignore(256, ')');
-    // skip over columns 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, and 13
-    // http://man7.org/linux/man-pages/man5/proc.5.html
-    for (int i = 0; i < 11; i++) {
-      linestream >> skip;
-    }
-    linestream >> utime >> stime >> cutime >> cstime;
-  }
-  return utime + stime + cutime + cstime;
+  ProcessStat stat;
+  Stat(pid, stat);
+  return stat.utime + stat.stime + stat.cutime + stat.cstime;
 }
 
 // Read and return the number of active jiffies for the system
 long LinuxParser::ActiveJiffies() {
-  string line;
-  string key;
-  long user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice;
-  long activeJiffies;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      // Read every line from /proc/stat, match on key = "cpu"
-      while (linestream >> key >> user >> nice >> system >> idle >> iowait >>
-             irq >> softirq >> steal >> guest >> guest_nice) {
-        if (key == "cpu") {
-          activeJiffies = user + nice + system + irq + softirq + steal;
-          break;
-        }
-      }
-    }
-  }
-
-  return activeJiffies;
+  long times[10]{};
+  AggregateCpu(times);
+  return times[kUser_] + times[kNice_] + times[kSystem_] + times[kIRQ_] +
+         times[kSoftIRQ_] + times[kSteal_];
 }
 
 // Done: Read and return the number of idle jiffies for the system
 long LinuxParser::IdleJiffies() {
-  string line;
-  string key;
-  long user, nice, system, idle, iowait, irq, softirq, steal, guest, guest_nice;
-  long idleJiffies;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      // Read every line from /proc/stat, match on key = "cpu"
-      while (linestream >> key >> user >> nice >> system >> idle >> iowait >>
-             irq >> softirq >> steal >> guest >> guest_nice) {
-        if (key == "cpu") {
-          idleJiffies = idle;
-          break;
-        }
-      }
-    }
-  }
-  return idleJiffies;
+  long times[10]{};
+  AggregateCpu(times);
+  return times[kIdle_];
 }
 
 // Return CPU Utilization as active jiffies / total jiffies.
@@ -274,143 +360,123 @@ float LinuxParser::CpuUtilization() {
 }
 
 // DONE: Read and return the total number of processes
-int LinuxParser::TotalProcesses() {
-  string line;
-  string key;
-  string value;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      // Read every line from /proc/stat, match on key = "processes"
-      while (linestream >> key >> value) {
-        if (key == "processes") {
-          std::replace(value.begin(), value.end(), '_', ' ');
-          return std::stoi(value);
-        }
-      }
-    }
-  }
-  return 0;
-}
+int LinuxParser::TotalProcesses() { return StatValue("processes "); }
 
 // Done: Read and return the number of running processes
-int LinuxParser::RunningProcesses() {
-  string line;
-  string key;
-  string value;
-  std::ifstream filestream(kProcDirectory + kStatFilename);
-  if (filestream.is_open()) {
-    while (std::getline(filestream, line)) {
-      std::istringstream linestream(line);
-      // Read every line from /proc/stat, match on key = "procs_running"
-      while (linestream >> key >> value) {
-        if (key == "procs_running") {
-          std::replace(value.begin(), value.end(), '_', ' ');
-          return std::stoi(value);
-        }
-      }
-    }
-  }
-  return 0;
-}
+int LinuxParser::RunningProcesses() { return StatValue("procs_running "); }
 
 // Done: Read and return the command associated with a process
 string LinuxParser::Command(int pid) {
+  // Linux stores the command used to launch the function in the
+  // /proc/[pid]/cmdline file, arguments separated by '\0'.
+  string_view cmdline = ProcReader::ReadPid(pid, kCmdlineFilename.c_str());
+  string_view command = cmdline.substr(0, cmdline.find('\0'));
+  command = NextToken(command);
   // default to "None" - if we don't find a cmdline entry, we won't
   // show the process. (May be special root only process)
-  string cmdline{"None"};
-  string line;
-  // Linux stores the command used to launch the function in the
-  // /proc/[pid]/cmdline file.
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       "/cmdline");
-  if (stream.is_open()) {
-    std::getline(stream, line);
-    std::istringstream linestream(line);
-    linestream >> cmdline;
-    //while (std::getline(stream, line)) {
-    //  std::istringstream linestream(line);
-    //  linestream >> cmdline;
-    //}
+  if (command.empty()) {
+    return "None";
   }
-  return cmdline;
+  return string(command);
 }
 
-// Done: Read and return the memory used by a process
-string LinuxParser::Ram(int pid) {
-  string key, vmsize_s;
-  long vmsize{0};
-  string line;
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       "/status");
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> vmsize;
-      if (key == "VmSize:") {
-        // vmsize = std::stol(ramUsed);
+// Read the fields of /proc/[PID]/status selected by mask in one pass.
+// Scanning stops as soon as every selected field has been found.
+// Returns false when the process has gone away.
+bool LinuxParser::Status(int pid, unsigned mask, ProcessStatus& status) {
+  static const struct {
+    StatusField field;
+    string_view key;
+    long ProcessStatus::*value;
+  } kFields[] = {
+      {kStatusUid, "Uid:", &ProcessStatus::uid},
+      {kStatusVmSize, "VmSize:", &ProcessStatus::vm_size},
+      {kStatusVmRss, "VmRSS:", &ProcessStatus::vm_rss},
+      {kStatusThreads, "Threads:", &ProcessStatus::threads},
+      {kStatusVoluntary, "voluntary_ctxt_switches:",
+       &ProcessStatus::voluntary_switches},
+      {kStatusNonvoluntary, "nonvoluntary_ctxt_switches:",
+       &ProcessStatus::nonvoluntary_switches},
+  };
+  status = ProcessStatus{};
+  string_view text = descriptors.Read(pid, FdCache::kStatus);
+  if (text.empty()) {
+    return false;
+  }
+  unsigned missing = mask;
+  while (missing != 0 && !text.empty()) {
+    string_view line = NextLine(text);
+    for (const auto& field : kFields) {
+      if ((missing & field.field) &&
+          line.substr(0, field.key.size()) == field.key) {
+        line.remove_prefix(field.key.size());
+        status.*field.value = ParseLong(NextToken(line));
+        missing &= ~field.field;
         break;
       }
     }
   }
-  // convert to MB
-  if (vmsize == 0) {
-    return "0";
-  } else {
-    vmsize = vmsize / 1024;
-    vmsize_s = std::to_string(vmsize);
-    return vmsize_s;
+  return true;
+}
+
+// Storage bytes of /proc/[PID]/io. Only root may read it for the
+// processes of other users. Not kept open: it is read for the rows shown,
+// and a third descriptor per process would shrink the FdCache.
+bool LinuxParser::Io(int pid, ProcessIo& io) {
+  io = ProcessIo{};
+  string_view text = ProcReader::ReadPid(pid, kIoFilename.c_str());
+  if (text.empty()) {
+    return false;
   }
+  string_view read = ProcReader::Value(text, "read_bytes:");
+  string_view write = ProcReader::Value(text, "write_bytes:");
+  io.read_bytes = ParseLong(NextToken(read));
+  io.write_bytes = ParseLong(NextToken(write));
+  return true;
+}
+
+// Done: Read and return the memory used by a process, in KiB
+// Resident, not VmSize: address space reserved but never touched is no
+// memory used.
+long LinuxParser::Ram(int pid) {
+  ProcessStatus status;
+  Status(pid, kStatusVmRss, status);
+  return status.vm_rss;
 }
 
 // Done: Read and return the user ID associated with a process
 string LinuxParser::Uid(int pid) {
-  string key, userId, readUserId;
-  string line;
-  std::ifstream stream(LinuxParser::kProcDirectory + std::to_string(pid) +
-                       "/status");
-  if (stream.is_open()) {
-    while (std::getline(stream, line)) {
-      std::istringstream linestream(line);
-      linestream >> key >> readUserId;
-      if (key == "Uid:") {
-        userId = readUserId;
-        break;
-      }
-    }
+  ProcessStatus status;
+  if (!Status(pid, kStatusUid, status)) {
+    return string();
   }
-  return userId;
+  return std::to_string(status.uid);
 }
 
 // Done: Read and return the user associated with a process
 string LinuxParser::User(int pid) {
-  // use /proc/<pid>/status and /etc/passwd
+  // use /proc/<pid>/status and the cached /etc/passwd
   // to obtain the user name.
-  string key, userId, dontCare, readUserName, readUserId;
-  string line;
-  string userName;
-  userId = Uid(pid);
-  std::ifstream unamestream(LinuxParser::kPasswordPath);
-  if (unamestream.is_open()) {
-    while (std::getline(unamestream, line)) {
-      std::replace(line.begin(), line.end(), ':', ' ');
-      std::istringstream linestreamuser(line);
-      linestreamuser >> readUserName >> dontCare >> readUserId;
-      if (readUserId == userId) {
-        // found matching user id in /etc/passwd, save it.
-        userName = readUserName;
-        break;
-      }
-    }
+  ProcessStatus status;
+  if (!Status(pid, kStatusUid, status)) {
+    return string();
   }
-  return userName;
+  return UserName(status.uid);
 }
 
+// Resolve a user id through the cached copy of /etc/passwd.
+string LinuxParser::UserName(int uid) { return users.Name(uid); }
+
+// Pick up changes to /etc/passwd; cheap enough to call every tick.
+void LinuxParser::RevalidateUsers() { users.Revalidate(); }
+
+// Close the kept descriptors of a process that has exited.
+void LinuxParser::Release(int pid) { descriptors.Forget(pid); }
+
 // Done: Read and return the uptime of a process
 long LinuxParser::UpTime(int pid) {
   // Use ActiveJiffies for process, divide by clock ticks.
   int hertz = sysconf(_SC_CLK_TCK);
   long jiffies = ActiveJiffies(pid);
   return jiffies / hertz;
-}
\ No newline at end of file
+}
@@ -1,7 +1,282 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "exporter.h"
+#include "metrics_log.h"
 #include "ncurses_display.h"
+#include "recorder.h"
 #include "system.h"
 
-int main() {
-  System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+// Time a full process scan with 1 .. max_threads collector threads.
+static void ReportScaling(int max_threads,
+                          const std::vector<std::string>& replay) {
+  const int ticks{5};
+  double single{0};
+  printf("threads  ms/scan  speedup\n");
+  for (int threads = 1; threads <= max_threads; ++threads) {
+    System system(threads);
+    if (!replay.empty()) {
+      system.Replay(replay);
+    }
+    // first scan fills the table; time the steady state after it.
+    system.Processes();
+    double total{0};
+    for (int tick = 0; tick < ticks; ++tick) {
+      system.Refresh();
+      system.Processes();
+      total += system.CollectionTime();
+    }
+    double average = total / ticks;
+    if (threads == 1) {
+      single = average;
+    }
+    printf("%7d  %7.2f  %7.2f\n", threads, average * 1000, single / average);
+  }
+}
+
+// Hand a sample to write every interval without ncurses; ticks < 0 runs
+// until the process is stopped or write fails. A tick that overruns the
+// interval delays the next one instead of being caught up on.
+template <typename Write>
+static bool Sample(System& system, std::chrono::milliseconds interval,
+                   int ticks, size_t top, Write write) {
+  auto next = std::chrono::steady_clock::now();
+  for (int tick = 0; ticks < 0 || tick < ticks; ++tick) {
+    auto time = std::chrono::system_clock::now();
+    system.Refresh();
+    const std::vector<Process>& processes = system.Processes();
+    if (!write(time, top > 0 ? system.Top(top) : processes)) {
+      return false;
+    }
+    next = std::max(next + interval, std::chrono::steady_clock::now());
+    std::this_thread::sleep_until(next);
+  }
+  return true;
+}
+
+static int Usage(const char* program) {
+  fprintf(stderr,
+          "usage: %s [--threads N] [--interval MS] [--scaling] "
+          "[--record DIR] [--ticks N] [--replay DIR] "
+          "[--export json|csv] [--output FILE] [--top N] "
+          "[--history MB] [--log DIR] [--log-size MB] [--open DIR] "
+          "[--at HH:MM] [--events] [--collector procfs|taskstats]\n",
+          program);
+  return 1;
+}
+
+// Parse all of text as a decimal number; false if it is not one or does
+// not fit value, which is then left alone.
+template <typename T>
+static bool Number(const char* text, T& value) {
+  const char* end = text + strlen(text);
+  auto [last, error] = std::from_chars(text, end, value);
+  return last != text && last == end && error == std::errc();
+}
+
+// The last tick of the log at or before a time of day, given as HH:MM or
+// HH:MM:SS, on the day of the log's last tick or the day before.
+static bool Seek(const MetricsLog::Reader& log, const std::string& at,
+                 size_t& tick) {
+  int hours{0}, minutes{0}, seconds{0};
+  if (sscanf(at.c_str(), "%d:%d:%d", &hours, &minutes, &seconds) < 2) {
+    return false;
+  }
+  auto end = log.Time(log.Ticks() - 1);
+  time_t when = std::chrono::system_clock::to_time_t(end);
+  tm local;
+  localtime_r(&when, &local);
+  local.tm_hour = hours;
+  local.tm_min = minutes;
+  local.tm_sec = seconds;
+  auto time = std::chrono::system_clock::from_time_t(mktime(&local));
+  if (time > end) {
+    time -= std::chrono::hours(24);
+  }
+  tick = log.Find(time);
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  int threads = std::thread::hardware_concurrency();
+  bool scaling{false};
+  int ticks{-1};
+  std::chrono::milliseconds interval{1000};
+  long milliseconds;
+  std::string record;
+  std::string replay;
+  std::string format;
+  std::string output;
+  size_t top{0};
+  size_t history{16};  // MB
+  std::string log;
+  size_t log_size{64};  // MB
+  std::string open_log;
+  std::string at;
+  bool events{false};
+  std::string collector{"procfs"};
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], threads) || threads < 1) {
+        return Usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "--scaling") == 0) {
+      scaling = true;
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record = argv[++i];
+    } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], ticks)) {
+        return Usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay = argv[++i];
+    } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], milliseconds)) {
+        return Usage(argv[0]);
+      }
+      interval = std::chrono::milliseconds(milliseconds);
+    } else if (strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+      format = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], top)) {
+        return Usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "--history") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], history)) {
+        return Usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+      log = argv[++i];
+    } else if (strcmp(argv[i], "--log-size") == 0 && i + 1 < argc) {
+      if (!Number(argv[++i], log_size)) {
+        return Usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "--open") == 0 && i + 1 < argc) {
+      open_log = argv[++i];
+    } else if (strcmp(argv[i], "--at") == 0 && i + 1 < argc) {
+      at = argv[++i];
+    } else if (strcmp(argv[i], "--events") == 0) {
+      events = true;
+    } else if (strcmp(argv[i], "--collector") == 0 && i + 1 < argc) {
+      collector = argv[++i];
+    } else {
+      return Usage(argv[0]);
+    }
+  }
+  if (interval < std::chrono::milliseconds(100)) {
+    fprintf(stderr, "%s: the interval is at least 100 ms\n", argv[0]);
+    return 1;
+  }
+  if (!format.empty() && format != "json" && format != "csv") {
+    fprintf(stderr, "%s: --export takes json or csv\n", argv[0]);
+    return 1;
+  }
+  if (collector != "procfs" && collector != "taskstats") {
+    fprintf(stderr, "%s: --collector takes procfs or taskstats\n", argv[0]);
+    return 1;
+  }
+  if (!open_log.empty()) {
+    MetricsLog::Reader reader(open_log);
+    if (reader.Ticks() == 0) {
+      fprintf(stderr, "%s: no logged ticks in %s\n", argv[0],
+              open_log.c_str());
+      return 1;
+    }
+    size_t tick{0};
+    if (!at.empty() && !Seek(reader, at, tick)) {
+      fprintf(stderr, "%s: --at takes HH:MM or HH:MM:SS\n", argv[0]);
+      return 1;
+    }
+    NCursesDisplay::Scrub(reader, tick);
+    return 0;
+  }
+  if (!record.empty()) {
+    if (!Recorder::Record(record, ticks < 0 ? 10 : ticks, interval)) {
+      fprintf(stderr, "%s: could not record to %s\n", argv[0],
+              record.c_str());
+      return 1;
+    }
+    return 0;
+  }
+  std::vector<std::string> recorded;
+  if (!replay.empty()) {
+    recorded = Recorder::Ticks(replay);
+    if (recorded.empty()) {
+      fprintf(stderr, "%s: no recorded ticks in %s\n", argv[0],
+              replay.c_str());
+      return 1;
+    }
+  }
+  if (scaling) {
+    ReportScaling(threads, recorded);
+    return 0;
+  }
+  System system(threads);
+  if (!recorded.empty()) {
+    system.Replay(recorded);
+  } else {
+    if (events && !system.WatchEvents()) {
+      fprintf(stderr,
+              "%s: no proc connector (it needs root); scanning /proc "
+              "instead\n",
+              argv[0]);
+    }
+    if (collector == "taskstats" &&
+        !system.UseCollector(Collector::kTaskstats)) {
+      fprintf(stderr,
+              "%s: no taskstats (it needs CAP_NET_ADMIN); reading "
+              "/proc/<pid>/stat instead\n",
+              argv[0]);
+    }
+  }
+  if (!format.empty()) {
+    int fd = STDOUT_FILENO;
+    if (!output.empty()) {
+      fd = open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+      if (fd < 0) {
+        perror(output.c_str());
+        return 1;
+      }
+    }
+    Exporter exporter(fd, format == "csv" ? Exporter::kCsv : Exporter::kJson);
+    bool written =
+        Sample(system, interval, ticks, top,
+               [&](auto time, const std::vector<Process>& processes) {
+                 return exporter.Write(time, system, processes);
+               });
+    if (!written) {
+      perror(output.empty() ? "stdout" : output.c_str());
+      return 1;
+    }
+    return 0;
+  }
+  if (!log.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(log, error);
+    MetricsLog::Writer writer(log, log_size << 20);
+    bool written = Sample(
+        system, interval, ticks, top,
+        [&](auto time, const std::vector<Process>& processes) {
+          return writer.Write(time, system, processes);
+        });
+    if (!written) {
+      perror(log.c_str());
+      return 1;
+    }
+    return 0;
+  }
+  NCursesDisplay::Display(system, interval, history << 20);
+}
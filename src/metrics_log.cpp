@@ -0,0 +1,541 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "metrics_log.h"
+
+namespace fs = std::filesystem;
+using std::size_t;
+using std::string;
+using std::uint64_t;
+using std::uint8_t;
+using std::vector;
+
+namespace MetricsLog {
+
+static const char kMagic[] = {'M', 'L', 'O', 'G'};
+static const size_t kHeaderSize{sizeof(kMagic) + 1};
+static const char kExtension[] = ".mlog";
+enum Tag : uint8_t { kString = 1, kTick = 2 };
+static const double kFraction{10000};
+
+static void PutVarint(vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value) | 0x80);
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+static void PutSigned(vector<uint8_t>& out, std::int64_t value) {
+  PutVarint(out, (static_cast<uint64_t>(value) << 1) ^ (value >> 63));
+}
+
+static void PutRecord(vector<uint8_t>& out, Tag tag, const uint8_t* data,
+                      size_t size) {
+  out.push_back(tag);
+  PutVarint(out, size);
+  out.insert(out.end(), data, data + size);
+}
+
+static long Fraction(float value) { return std::lround(value * kFraction); }
+
+// Reads varints from a payload. Past its end, or in a varint too long,
+// every read returns 0 and ok turns false.
+struct Cursor {
+  const uint8_t* at;
+  const uint8_t* end;
+  bool ok{true};
+
+  uint64_t Varint() {
+    uint64_t value{0};
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (at == end) {
+        break;
+      }
+      uint8_t byte = *at++;
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    at = end;
+    return 0;
+  }
+  std::int64_t Signed() {
+    uint64_t value = Varint();
+    return static_cast<std::int64_t>(value >> 1) ^ -(std::int64_t)(value & 1);
+  }
+};
+
+// Files of a log directory, oldest first; names sort by their number.
+static vector<fs::path> Files(const string& directory) {
+  vector<fs::path> files;
+  std::error_code error;
+  for (const auto& entry : fs::directory_iterator(directory, error)) {
+    if (entry.path().extension() == kExtension) {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+Writer::Writer(string directory, size_t max_size)
+    : directory_(std::move(directory)), max_size_(max_size) {}
+
+Writer::~Writer() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+size_t Writer::Bytes() const { return bytes_; }
+
+// Start the next file: after the last one of the directory at first,
+// then after the one just filled. Everything a file refers to is in it.
+bool Writer::Open() {
+  if (file_ < 0) {
+    vector<fs::path> files = Files(directory_);
+    file_ = files.empty() ? 0 : std::atoi(files.back().stem().c_str()) + 1;
+  } else {
+    ++file_;
+  }
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s/%06d%s", directory_.c_str(), file_,
+           kExtension);
+  fd_ = open(path, O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  out_.assign(kMagic, kMagic + sizeof(kMagic));
+  out_.push_back(kVersion);
+  if (write(fd_, out_.data(), out_.size()) != (ssize_t)out_.size()) {
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  size_ = out_.size();
+  bytes_ += size_;
+  ticks_ = 0;
+  strings_.clear();
+  previous_.clear();
+  return true;
+}
+
+// Number of text in the open file; the first use writes it out, ahead of
+// the tick that refers to it. The number is taken before the write; a
+// failed one ends the file, so it is never used again.
+uint64_t Writer::Intern(const string& text) {
+  auto found = strings_.find(text);
+  if (found != strings_.end()) {
+    return found->second;
+  }
+  uint64_t id = strings_.size();
+  strings_.emplace(text, id);
+  PutRecord(out_, kString, reinterpret_cast<const uint8_t*>(text.data()),
+            text.size());
+  return id;
+}
+
+// Append one tick; see the top of include/metrics_log.h for the layout.
+bool Writer::Write(std::chrono::system_clock::time_point time,
+                   System& system, const vector<Process>& processes) {
+  if (fd_ < 0 && !Open()) {
+    return false;
+  }
+  std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         time.time_since_epoch())
+                         .count();
+  bool keyframe = ticks_ % kKeyframe == 0;
+  if (keyframe) {
+    previous_.clear();
+  }
+  current_.clear();
+  for (const Process& process : processes) {
+    current_.push_back({process.Pid(), process.StartTime(),
+                        Fraction(process.CpuUtilization()), process.Ram(),
+                        process.UpTime(), &process});
+  }
+  std::sort(current_.begin(), current_.end(),
+            [](const Entry& a, const Entry& b) { return a.pid < b.pid; });
+
+  out_.clear();
+  payload_.clear();
+  PutVarint(payload_, keyframe);
+  PutSigned(payload_, now - (keyframe ? 0 : time_));
+  PutVarint(payload_, Intern(system.OperatingSystem()));
+  PutVarint(payload_, Intern(system.Kernel()));
+  const CpuLoad& load = system.Cpu().Load();
+  for (float value : {load.utilization, load.user, load.system, load.iowait,
+                      load.steal, system.MemoryUtilization()}) {
+    PutVarint(payload_, std::max(0L, Fraction(value)));
+  }
+  for (long value :
+       {(long)system.Cpu().Cores(), (long)system.TotalProcesses(),
+        (long)system.RunningProcesses(), system.UpTime(),
+        (long)system.Started(), (long)system.Exited(), system.OpensPerTick(),
+        std::lround(system.CollectionTime() * 1e6), (long)system.Threads()}) {
+    PutVarint(payload_, std::max(0L, value));
+  }
+  PutVarint(payload_, current_.size());
+  int pid{0};
+  auto before = previous_.begin();
+  for (const Entry& entry : current_) {
+    while (before != previous_.end() && before->pid < entry.pid) {
+      ++before;
+    }
+    bool fresh = before == previous_.end() || before->pid != entry.pid ||
+                 before->starttime != entry.starttime;
+    PutVarint(payload_, (uint64_t)(entry.pid - pid) << 1 | fresh);
+    pid = entry.pid;
+    if (fresh) {
+      PutVarint(payload_, Intern(entry.process->User()));
+      PutVarint(payload_, Intern(entry.process->Command()));
+      PutVarint(payload_, std::max(0L, entry.cpu));
+      PutVarint(payload_, std::max(0L, entry.ram));
+      PutVarint(payload_, std::max(0L, entry.cpu_time));
+    } else {
+      PutSigned(payload_, entry.cpu - before->cpu);
+      PutSigned(payload_, entry.ram - before->ram);
+      PutSigned(payload_, entry.cpu_time - before->cpu_time);
+    }
+  }
+  PutRecord(out_, kTick, payload_.data(), payload_.size());
+
+  for (size_t written = 0; written < out_.size();) {
+    ssize_t count = write(fd_, out_.data() + written, out_.size() - written);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      // The file now ends in part of a record, which the reader drops,
+      // and strings_ numbers strings that may not have made it out. Give
+      // up on the file; the next call starts a fresh one.
+      bytes_ += written;
+      close(fd_);
+      fd_ = -1;
+      strings_.clear();
+      return false;
+    }
+    written += count;
+  }
+  previous_.swap(current_);
+  time_ = now;
+  ++ticks_;
+  size_ += out_.size();
+  bytes_ += out_.size();
+  if (size_ >= max_size_) {
+    close(fd_);
+    fd_ = -1;
+  }
+  return true;
+}
+
+// Map every file of the directory; ones that cannot be read are left out.
+Reader::Reader(const string& directory) {
+  for (const fs::path& path : Files(directory)) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) {
+      continue;
+    }
+    files_.emplace_back();
+    files_.back().data = static_cast<const uint8_t*>(data);
+    files_.back().size = info.st_size;
+    Index(files_.size() - 1);
+  }
+}
+
+Reader::~Reader() {
+  for (File& file : files_) {
+    munmap(const_cast<uint8_t*>(file.data), file.size);
+  }
+}
+
+// Collect the strings of a file and where each tick lies. A file cut
+// short, as the one being written may be, ends at its last whole record.
+void Reader::Index(size_t number) {
+  File& file = files_[number];
+  if (file.size < kHeaderSize ||
+      memcmp(file.data, kMagic, sizeof(kMagic)) != 0 ||
+      file.data[sizeof(kMagic)] != kVersion) {
+    return;
+  }
+  Cursor cursor{file.data + kHeaderSize, file.data + file.size};
+  std::int64_t time{0};
+  while (cursor.at < cursor.end) {
+    uint8_t tag = *cursor.at++;
+    uint64_t size = cursor.Varint();
+    if (!cursor.ok || size > (uint64_t)(cursor.end - cursor.at)) {
+      break;
+    }
+    const uint8_t* payload = cursor.at;
+    cursor.at += size;
+    if (tag == kString) {
+      file.strings.emplace_back(reinterpret_cast<const char*>(payload), size);
+    } else if (tag == kTick) {
+      Cursor header{payload, payload + size};
+      bool keyframe = header.Varint() & 1;
+      std::int64_t delta = header.Signed();
+      time = keyframe ? delta : time + delta;
+      ticks_.push_back({number, (size_t)(payload - file.data), size, time,
+                        keyframe});
+    }
+  }
+}
+
+size_t Reader::Ticks() const { return ticks_.size(); }
+
+std::chrono::system_clock::time_point Reader::Time(size_t tick) const {
+  return std::chrono::system_clock::time_point(
+      std::chrono::milliseconds(ticks_[tick].time));
+}
+
+size_t Reader::Find(std::chrono::system_clock::time_point time) const {
+  std::int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        time.time_since_epoch())
+                        .count();
+  auto after = std::upper_bound(
+      ticks_.begin(), ticks_.end(), ms,
+      [](std::int64_t at, const Tick& tick) { return at < tick.time; });
+  return after == ticks_.begin() ? 0 : after - ticks_.begin() - 1;
+}
+
+// String number id of a file, or an empty one if there is no such string.
+static const string& Text(const vector<string>& strings, uint64_t id) {
+  static const string none;
+  return id < strings.size() ? strings[id] : none;
+}
+
+// The system values of a tick, which follow its flags and time.
+static void ReadSystem(Cursor& cursor, const vector<string>& strings,
+                       Frame& frame) {
+  frame.os = Text(strings, cursor.Varint());
+  frame.kernel = Text(strings, cursor.Varint());
+  for (float* value : {&frame.cpu.utilization, &frame.cpu.user,
+                       &frame.cpu.system, &frame.cpu.iowait, &frame.cpu.steal,
+                       &frame.memory}) {
+    *value = cursor.Varint() / kFraction;
+  }
+  frame.cores = cursor.Varint();
+  frame.total_processes = cursor.Varint();
+  frame.running_processes = cursor.Varint();
+  frame.uptime = cursor.Varint();
+  frame.started = cursor.Varint();
+  frame.exited = cursor.Varint();
+  frame.opens_per_tick = cursor.Varint();
+  frame.collection_time = cursor.Varint() / 1e6;
+  frame.threads = cursor.Varint();
+}
+
+// Decode tick into entries_ and its system values into frame, starting
+// from the tick read last if it lies between tick and its keyframe.
+bool Reader::Decode(size_t tick, Frame& frame) {
+  size_t first = tick;
+  while (first > 0 && !ticks_[first].keyframe) {
+    --first;
+  }
+  if (valid_ && decoded_ >= first && decoded_ <= tick) {
+    first = decoded_ + 1;
+  }
+  if (first > tick) {
+    // Already decoded; only the system values are wanted.
+    const Tick& at = ticks_[tick];
+    const File& file = files_[at.file];
+    Cursor cursor{file.data + at.offset, file.data + at.offset + at.size};
+    cursor.Varint();
+    cursor.Signed();
+    ReadSystem(cursor, file.strings, frame);
+    return cursor.ok;
+  }
+  for (size_t step = first; step <= tick; ++step) {
+    if (!Step(step, frame)) {
+      valid_ = false;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Decode the tick after decoded_, or a keyframe.
+bool Reader::Step(size_t tick, Frame& frame) {
+  const Tick& at = ticks_[tick];
+  const File& file = files_[at.file];
+  Cursor cursor{file.data + at.offset, file.data + at.offset + at.size};
+  cursor.Varint();
+  cursor.Signed();
+  ReadSystem(cursor, file.strings, frame);
+  uint64_t count = cursor.Varint();
+  next_.clear();
+  int pid{0};
+  auto before = entries_.cbegin();
+  for (uint64_t i = 0; i < count && cursor.ok; ++i) {
+    uint64_t key = cursor.Varint();
+    pid += key >> 1;
+    Entry entry{pid, 0, 0, 0, nullptr, nullptr};
+    if (key & 1) {
+      entry.user = &Text(file.strings, cursor.Varint());
+      entry.command = &Text(file.strings, cursor.Varint());
+      entry.cpu = cursor.Varint();
+      entry.ram = cursor.Varint();
+      entry.cpu_time = cursor.Varint();
+    } else {
+      while (before != entries_.cend() && before->pid < pid) {
+        ++before;
+      }
+      if (before == entries_.cend() || before->pid != pid) {
+        return false;  // a change to a process the last tick did not have
+      }
+      entry = *before;
+      entry.cpu += cursor.Signed();
+      entry.ram += cursor.Signed();
+      entry.cpu_time += cursor.Signed();
+    }
+    next_.push_back(entry);
+  }
+  entries_.swap(next_);
+  decoded_ = tick;
+  valid_ = cursor.ok;
+  return valid_;
+}
+
+// Sparklines of the last Frame::kTrail ticks and the range of the last
+// Frame::kSpan, from the system values alone.
+void Reader::Summarize(size_t tick, Frame& frame) {
+  std::fill(std::begin(frame.cpu_trail), std::end(frame.cpu_trail), NAN);
+  std::fill(std::begin(frame.memory_trail), std::end(frame.memory_trail),
+            NAN);
+  History::Summary cpu{std::numeric_limits<float>::max(), 0, 0, 0};
+  History::Summary memory = cpu;
+  const std::int64_t span =
+      std::chrono::duration_cast<std::chrono::milliseconds>(Frame::kSpan)
+          .count();
+  for (size_t back = 0; back <= tick; ++back) {
+    const Tick& at = ticks_[tick - back];
+    bool trail = back < Frame::kTrail;
+    bool range = ticks_[tick].time - at.time < span;
+    if (!trail && !range) {
+      break;
+    }
+    const File& file = files_[at.file];
+    Cursor cursor{file.data + at.offset, file.data + at.offset + at.size};
+    cursor.Varint();
+    cursor.Signed();
+    ReadSystem(cursor, file.strings, header_);
+    if (trail) {
+      frame.cpu_trail[Frame::kTrail - 1 - back] = header_.cpu.utilization;
+      frame.memory_trail[Frame::kTrail - 1 - back] = header_.memory;
+    }
+    if (range) {
+      for (auto [summary, value] : {std::pair{&cpu, header_.cpu.utilization},
+                                    std::pair{&memory, header_.memory}}) {
+        summary->min = std::min(summary->min, value);
+        summary->max = std::max(summary->max, value);
+        summary->average += value;
+        ++summary->samples;
+      }
+    }
+  }
+  for (History::Summary* summary : {&cpu, &memory}) {
+    if (summary->samples > 0) {
+      summary->average /= summary->samples;
+    }
+  }
+  frame.cpu_range = cpu;
+  frame.memory_range = memory;
+}
+
+// Fill frame with tick, its processes ranked by sort as System::Top()
+// ranks them.
+bool Reader::Read(size_t tick, ProcessTable::Column sort, size_t count,
+                  Frame& frame) {
+  if (tick >= ticks_.size() || !Decode(tick, frame)) {
+    return false;
+  }
+  Summarize(tick, frame);
+  frame.time = Time(tick);
+  frame.sort = sort;
+  frame.processes = entries_.size();
+
+  order_.resize(entries_.size());
+  for (uint32_t i = 0; i < order_.size(); ++i) {
+    order_[i] = i;
+  }
+  auto before = [&](uint32_t left, uint32_t right) {
+    const Entry& a = entries_[left];
+    const Entry& b = entries_[right];
+    switch (sort) {
+      case ProcessTable::kUser:
+        if (*a.user != *b.user) {
+          return *a.user < *b.user;
+        }
+        break;
+      case ProcessTable::kCpu:
+        if (a.cpu != b.cpu) {
+          return a.cpu > b.cpu;
+        }
+        break;
+      case ProcessTable::kRam:
+        if (a.ram != b.ram) {
+          return a.ram > b.ram;
+        }
+        break;
+      case ProcessTable::kUpTime:
+        if (a.cpu_time != b.cpu_time) {
+          return a.cpu_time > b.cpu_time;
+        }
+        break;
+      case ProcessTable::kPid:
+      case ProcessTable::kRead:   // not logged
+      case ProcessTable::kWrite:  // not logged
+        break;
+    }
+    return a.pid < b.pid;
+  };
+  count = std::min(count, order_.size());
+  std::partial_sort(order_.begin(), order_.begin() + count, order_.end(),
+                    before);
+  frame.rows.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Entry& entry = entries_[order_[i]];
+    Frame::Row& row = frame.rows[i];
+    row.pid = entry.pid;
+    size_t length = std::min(entry.user->size(), sizeof(row.user) - 1);
+    std::copy_n(entry.user->data(), length, row.user);
+    row.user[length] = '\0';
+    row.cpu = entry.cpu / kFraction;
+    row.ram = entry.ram;
+    row.read_rate = row.write_rate = -1;
+    row.uptime = entry.cpu_time;
+    row.command = *entry.command;
+    row.average = NAN;
+    std::fill(std::begin(row.trail), std::end(row.trail), NAN);
+  }
+  return true;
+}
+
+};  // namespace MetricsLog
@@ -1,113 +1,677 @@
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "format.h"
+#include "frame.h"
+#include "history.h"
+#include "metrics_log.h"
 #include "ncurses_display.h"
+#include "sampler.h"
 #include "system.h"
 
 using std::string;
-using std::to_string;
+
+// Milliseconds to wait for a key before looking for a new frame.
+static const int kKeyWait{20};
+
+// Longest line drawn; wider terminals leave the rest blank.
+static const int kLineSize{512};
+
+// Rows of the system window, and its width when panels sit next to it.
+static const int kSystemHeight{13};
+static const int kSystemWidth{78};
+// Width the disk and network panels need for their columns, and the
+// height of one panel.
+static const int kPanelWidth{50};
+static const int kPanelHeight{6};
+// Process rows the panels may not squeeze out.
+static const int kMinProcessRows{5};
+// Width of the process window from which AVG1m and HISTORY are shown.
+static const int kWideProcesses{100};
+
+// Put text at row, column. doupdate() sends only the cells that differ
+// from the terminal, so an unchanged line costs no bytes and reading the
+// window back first would only repeat that comparison.
+// Lines that shrink must be padded, or the end of the old text stays.
+static void DrawText(WINDOW* window, int row, int column, const char* text) {
+  mvwaddnstr(window, row, column, text, kLineSize - 1);
+}
+
+// A heading at row and column, cut off at the right border rather than
+// wrapped onto the next row.
+static void Title(WINDOW* window, int row, int column, const char* text) {
+  int room = getmaxx(window) - 1 - column;
+  if (room > 0) {
+    mvwaddnstr(window, row, column, text, room);
+  }
+}
+
+// Format into line and pad it with spaces to width.
+static const char* Pad(char (&line)[kLineSize], int width, const char* format,
+                       ...) {
+  width = std::clamp(width, 0, kLineSize - 1);
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(line, sizeof(line), format, arguments);
+  va_end(arguments);
+  length = std::clamp(length, 0, width);
+  std::fill(line + length, line + width, ' ');
+  line[width] = '\0';
+  return line;
+}
 
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
-std::string NCursesDisplay::ProgressBar(float percent) {
-  std::string result{"0%"};
-  int size{50};
-  float bars{percent * size};
-
-  for (int i{0}; i < size; ++i) {
-    result += i <= bars ? '|' : ' ';
+const char* NCursesDisplay::ProgressBar(float percent, char* buffer,
+                                        size_t size) {
+  const int bars{50};
+  char bar[bars + 1];
+  for (int i{0}; i < bars; ++i) {
+    bar[i] = i <= percent * bars ? '|' : ' ';
+  }
+  bar[bars] = '\0';
+  // The first four characters of the percentage, or a space and three.
+  char display[32];
+  snprintf(display, sizeof(display), "%f", percent * 100);
+  if (percent < 0.1 || percent == 1.0) {
+    memmove(display + 1, display, 3);
+    display[0] = ' ';
   }
+  display[4] = '\0';
+  snprintf(buffer, size, "0%%%s %s/100%%", bar, display);
+  return buffer;
+}
 
-  string display{to_string(percent * 100).substr(0, 4)};
-  if (percent < 0.1 || percent == 1.0)
-    display = " " + to_string(percent * 100).substr(0, 3);
-  return result + " " + display + "/100%";
+// One character per value, taller for larger ones up to scale; a blank
+// where a value is unknown. buffer takes count + 1 characters.
+const char* NCursesDisplay::Sparkline(const float* values, size_t count,
+                                      float scale, char* buffer) {
+  static const char levels[] = "_.:-=+*#@";
+  const int top = sizeof(levels) - 2;
+  for (size_t i = 0; i < count; ++i) {
+    if (std::isnan(values[i])) {
+      buffer[i] = ' ';
+      continue;
+    }
+    int level = std::lround(values[i] / scale * top);
+    buffer[i] = levels[std::clamp(level, 0, top)];
+  }
+  buffer[count] = '\0';
+  return buffer;
 }
 
-void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+void NCursesDisplay::DisplaySystem(const Frame& frame, WINDOW* window) {
   int row{0};
-  mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
-  mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
-  mvwprintw(window, ++row, 2, "CPU: ");
+  int width = getmaxx(window) - 3;
+  char line[kLineSize];
+  char bar[128];
+  DrawText(window, ++row, 2, Pad(line, width, "OS: %s", frame.os.c_str()));
+  DrawText(window, ++row, 2,
+           Pad(line, width, "Kernel: %s", frame.kernel.c_str()));
+  DrawText(window, ++row, 2, "CPU: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
+  DrawText(window, row, 10,
+           ProgressBar(frame.cpu.utilization, bar, sizeof(bar)));
   wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2, "Memory: ");
+  const CpuLoad& load = frame.cpu;
+  DrawText(window, ++row, 10,
+           Pad(line, width - 8,
+               "usr %4.1f%%  sys %4.1f%%  iow %4.1f%%  st %4.1f%%  "
+               "(%d cores)",
+               load.user * 100, load.system * 100, load.iowait * 100,
+               load.steal * 100, frame.cores));
+  DrawText(window, ++row, 2, "Memory: ");
   wattron(window, COLOR_PAIR(1));
-  mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
+  DrawText(window, row, 10, ProgressBar(frame.memory, bar, sizeof(bar)));
   wattroff(window, COLOR_PAIR(1));
-  mvwprintw(window, ++row, 2,
-            ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
-  mvwprintw(
-      window, ++row, 2,
-      ("Running Processes: " + to_string(system.RunningProcesses())).c_str());
-  mvwprintw(window, ++row, 2,
-            ("Up Time: " + Format::ElapsedTime(system.UpTime())).c_str());
-  wrefresh(window);
-}
-
-void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
-                                      WINDOW* window, int n) {
+  // The last minute of each, from the sampler's history.
+  char trail[Frame::kTrail + 1];
+  auto range = [&](const char* name, const History::Summary& summary,
+                   const float* values) {
+    DrawText(window, ++row, 2,
+             Pad(line, width,
+                 "%-6s  min %5.1f%%  avg %5.1f%%  max %5.1f%%  %s", name,
+                 summary.min * 100, summary.average * 100, summary.max * 100,
+                 Sparkline(values, Frame::kTrail, 1, trail)));
+  };
+  range("CPU 1m", frame.cpu_range, frame.cpu_trail);
+  range("Mem 1m", frame.memory_range, frame.memory_trail);
+  if (frame.short_lived < 0) {
+    DrawText(window, ++row, 2,
+             Pad(line, width, "Total Processes: %d  (+%d -%d this tick)",
+                 frame.total_processes, frame.started, frame.exited));
+  } else {
+    DrawText(window, ++row, 2,
+             Pad(line, width,
+                 "Total Processes: %d  (+%d -%d this tick, %d too short "
+                 "to see)",
+                 frame.total_processes, frame.started, frame.exited,
+                 frame.short_lived));
+  }
+  DrawText(window, ++row, 2,
+           Pad(line, width, "Running Processes: %d",
+               frame.running_processes));
+  char time[32];
+  DrawText(window, ++row, 2,
+           Pad(line, width, "Up Time: %s",
+               Format::ElapsedTime(frame.uptime, time, sizeof(time))));
+  DrawText(window, ++row, 2,
+           Pad(line, width, "Opens/Tick: %ld  Scan: %.1f ms (%d threads%s%s)",
+               frame.opens_per_tick, frame.collection_time * 1000,
+               frame.threads, *frame.collector != '\0' ? ", " : "",
+               frame.collector));
+}
+
+// Throughput, latency and utilization of each disk, as many as fit.
+void NCursesDisplay::DisplayDisks(const Frame& frame, WINDOW* window) {
+  int row{0};
+  int const name_column{2};
+  int const read_column{12};
+  int const write_column{20};
+  int const read_wait_column{29};
+  int const write_wait_column{36};
+  int const utilization_column{43};
+  Title(window, 0, 2, " Disks ");
+  ++row;
+  wattron(window, COLOR_PAIR(2));
+  Title(window, row, name_column, "DEVICE");
+  Title(window, row, read_column, "READ/s");
+  Title(window, row, write_column, "WRITE/s");
+  Title(window, row, read_wait_column, "R ms");
+  Title(window, row, write_wait_column, "W ms");
+  Title(window, row, utilization_column, "UTIL");
+  wattroff(window, COLOR_PAIR(2));
+  int width = std::clamp(getmaxx(window) - 2, 0, kLineSize - 1);
+  int rows = getmaxy(window) - 3;
+  char line[kLineSize];
+  char field[32];
+  auto put = [&](int column, const char* text) {
+    for (int i = column - 1; *text != '\0' && i < width; ++i) {
+      line[i] = *text++;
+    }
+  };
+  for (int i = 0; i < rows; ++i) {
+    std::fill(line, line + width, ' ');
+    line[width] = '\0';
+    if (i < (int)frame.disks.size()) {
+      const DiskLoad& disk = frame.disks[i];
+      put(name_column, disk.name);
+      put(read_column, Format::Bytes(disk.read_rate, field, sizeof(field)));
+      put(write_column, Format::Bytes(disk.write_rate, field, sizeof(field)));
+      snprintf(field, sizeof(field), "%.1f", disk.read_wait);
+      put(read_wait_column, field);
+      snprintf(field, sizeof(field), "%.1f", disk.write_wait);
+      put(write_wait_column, field);
+      snprintf(field, sizeof(field), "%3.0f%%", disk.utilization * 100);
+      put(utilization_column, field);
+    }
+    DrawText(window, ++row, 1, line);
+  }
+}
+
+// Traffic of each interface, as many as fit, and TCP retransmits on the
+// top border.
+void NCursesDisplay::DisplayNetwork(const Frame& frame, WINDOW* window) {
   int row{0};
+  int const name_column{2};
+  int const receive_column{11};
+  int const transmit_column{19};
+  int const receive_packet_column{27};
+  int const transmit_packet_column{35};
+  int const drop_column{43};
+  char line[kLineSize];
+  char field[32];
+  snprintf(line, sizeof(line), " Network  TCP retrans %.1f/s %.2f%% ",
+           frame.retransmit_rate, frame.retransmit_share * 100);
+  Title(window, 0, 2, line);
+  ++row;
+  wattron(window, COLOR_PAIR(2));
+  Title(window, row, name_column, "IFACE");
+  Title(window, row, receive_column, "RX/s");
+  Title(window, row, transmit_column, "TX/s");
+  Title(window, row, receive_packet_column, "RXpk/s");
+  Title(window, row, transmit_packet_column, "TXpk/s");
+  Title(window, row, drop_column, "DROP/s");
+  wattroff(window, COLOR_PAIR(2));
+  int width = std::clamp(getmaxx(window) - 2, 0, kLineSize - 1);
+  int rows = getmaxy(window) - 3;
+  auto put = [&](int column, const char* text) {
+    for (int i = column - 1; *text != '\0' && i < width; ++i) {
+      line[i] = *text++;
+    }
+  };
+  for (int i = 0; i < rows; ++i) {
+    std::fill(line, line + width, ' ');
+    line[width] = '\0';
+    if (i < (int)frame.interfaces.size()) {
+      const InterfaceLoad& interface = frame.interfaces[i];
+      put(name_column, interface.name);
+      put(receive_column,
+          Format::Bytes(interface.receive_rate, field, sizeof(field)));
+      put(transmit_column,
+          Format::Bytes(interface.transmit_rate, field, sizeof(field)));
+      snprintf(field, sizeof(field), "%.0f", interface.receive_packet_rate);
+      put(receive_packet_column, field);
+      snprintf(field, sizeof(field), "%.0f", interface.transmit_packet_rate);
+      put(transmit_packet_column, field);
+      snprintf(field, sizeof(field), "%.0f", interface.drop_rate);
+      put(drop_column, field);
+    }
+    DrawText(window, ++row, 1, line);
+  }
+}
+
+// Show n rows of processes, starting at rank offset.
+// Each row is formatted whole into a buffer and drawn with one call;
+// doupdate() then sends the terminal only the cells that changed.
+void NCursesDisplay::DisplayProcesses(const Frame& frame, WINDOW* window,
+                                      int n, size_t offset) {
+  int row{0};
+  // AVG1m and HISTORY only where COMMAND still has room after them.
+  bool wide = getmaxx(window) >= kWideProcesses;
+  int const average_width = wide ? 8 : 0;
+  int const history_width = wide ? 14 : 0;
   int const pid_column{2};
   int const user_column{9};
   int const cpu_column{16};
-  int const ram_column{26};
-  int const time_column{35};
-  int const command_column{46};
+  int const average_column{24};
+  int const ram_column{24 + average_width};
+  int const time_column{33 + average_width};
+  int const history_column{52};
+  int const read_column{44 + average_width + history_width};
+  int const write_column{52 + average_width + history_width};
+  int const command_column{61 + average_width + history_width};
+  // The column the list is sorted by is shown in reverse video.
+  auto heading = [&](int column, const char* title, ProcessTable::Column key) {
+    attr_t attributes =
+        COLOR_PAIR(2) | (key == frame.sort ? A_REVERSE : A_NORMAL);
+    wattron(window, attributes);
+    Title(window, row, column, title);
+    wattroff(window, attributes);
+  };
+  ++row;
+  heading(pid_column, "PID", ProcessTable::kPid);
+  heading(user_column, "USER", ProcessTable::kUser);
+  heading(cpu_column, "CPU[%]", ProcessTable::kCpu);
+  heading(ram_column, "RAM[MB]", ProcessTable::kRam);
+  heading(time_column, "TIME+", ProcessTable::kUpTime);
+  heading(read_column, "READ/s", ProcessTable::kRead);
+  heading(write_column, "WRITE/s", ProcessTable::kWrite);
+  wattron(window, COLOR_PAIR(2));
+  if (wide) {
+    Title(window, row, average_column, "AVG1m");
+    Title(window, row, history_column, "HISTORY");
+  }
+  Title(window, row, command_column, "COMMAND");
+  wattroff(window, COLOR_PAIR(2));
+  // Rows span the window between its borders, from column 1.
+  int width = std::clamp(getmaxx(window) - 2, 0, kLineSize - 1);
+  char line[kLineSize];
+  char field[32];
+  // Later fields overwrite the end of a longer earlier one.
+  auto put = [&](int column, const char* text) {
+    for (int i = column - 1; *text != '\0' && i < width; ++i) {
+      line[i] = *text++;
+    }
+  };
+  for (size_t i = offset; i < offset + n; ++i) {
+    std::fill(line, line + width, ' ');
+    line[width] = '\0';
+    if (i < frame.rows.size()) {
+      const Frame::Row& process = frame.rows[i];
+      snprintf(field, sizeof(field), "%d", process.pid);
+      put(pid_column, field);
+      put(user_column, process.user);
+      snprintf(field, sizeof(field), "%f", process.cpu * 100);
+      field[4] = '\0';
+      put(cpu_column, field);
+      if (wide && std::isnan(process.average)) {
+        put(average_column, "-");
+      } else if (wide) {
+        snprintf(field, sizeof(field), "%f", process.average * 100);
+        field[4] = '\0';
+        put(average_column, field);
+      }
+      if (wide) {
+        // Each process to its own peak, or small ones would not show.
+        float peak{0.01};
+        for (float value : process.trail) {
+          peak = std::isnan(value) ? peak : std::max(peak, value);
+        }
+        put(history_column,
+            Sparkline(process.trail, Frame::kRowTrail, peak, field));
+      }
+      snprintf(field, sizeof(field), "%ld", process.ram / 1024);
+      put(ram_column, field);
+      put(time_column,
+          Format::ElapsedTime(process.uptime, field, sizeof(field)));
+      put(read_column, Format::Bytes(process.read_rate, field, sizeof(field)));
+      put(write_column,
+          Format::Bytes(process.write_rate, field, sizeof(field)));
+      put(command_column, process.command.c_str());
+    }
+    DrawText(window, ++row, 1, line);
+  }
+}
+
+// Show n rows of the threads of the busiest processes, starting at rank
+// offset, busiest first. Each row is formatted whole and drawn with one
+// call, leaving curses to send only what changed, as DisplayProcesses()
+// does.
+void NCursesDisplay::DisplayThreads(const Frame& frame, WINDOW* window,
+                                    int n, size_t offset) {
+  int row{0};
+  int const tid_column{2};
+  int const pid_column{10};
+  int const cpu_column{18};
+  int const state_column{26};
+  int const time_column{29};
+  int const name_column{40};
+  int const command_column{57};
+  char line[kLineSize];
+  if (frame.threads_skipped > 0) {
+    snprintf(line, sizeof(line), " threads: %zu read, %zu more not ",
+             frame.thread_count, frame.threads_skipped);
+    mvwaddstr(window, 0, 2, line);
+  } else {
+    snprintf(line, sizeof(line), " threads: %zu ", frame.thread_count);
+    mvwaddstr(window, 0, 2, line);
+  }
+  ++row;
   wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column, "PID");
-  mvwprintw(window, row, user_column, "USER");
-  mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
+  Title(window, row, tid_column, "TID");
+  Title(window, row, pid_column, "PID");
+  wattron(window, A_REVERSE);
+  Title(window, row, cpu_column, "CPU[%]");
+  wattroff(window, A_REVERSE);
+  Title(window, row, state_column, "S");
+  Title(window, row, time_column, "TIME+");
+  Title(window, row, name_column, "THREAD");
+  Title(window, row, command_column, "PROCESS");
   wattroff(window, COLOR_PAIR(2));
-  // Blank line up to max X of window
-  // to clear out artifacts from process info moving up and down the list.
-  std::string clear_line = std::string((window->_maxx - 1), ' ');
-  for (int i = 0; i < n; ++i) {
-    mvwprintw(window, ++row, 1, clear_line.c_str());
-    mvwprintw(window, row, pid_column, to_string(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-    mvwprintw(window, row, ram_column, processes[i].Ram().c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              processes[i].Command().substr(0, window->_maxx - 46).c_str());
-  }
-}
-
-void NCursesDisplay::Display(System& system, int n) {
+  int width = std::clamp(getmaxx(window) - 2, 0, kLineSize - 1);
+  char field[32];
+  auto put = [&](int column, const char* text) {
+    for (int i = column - 1; *text != '\0' && i < width; ++i) {
+      line[i] = *text++;
+    }
+  };
+  for (size_t i = offset; i < offset + n; ++i) {
+    std::fill(line, line + width, ' ');
+    line[width] = '\0';
+    if (i < frame.thread_rows.size()) {
+      const Frame::ThreadRow& thread = frame.thread_rows[i];
+      snprintf(field, sizeof(field), "%d", thread.tid);
+      put(tid_column, field);
+      snprintf(field, sizeof(field), "%d", thread.pid);
+      put(pid_column, field);
+      snprintf(field, sizeof(field), "%f", thread.cpu * 100);
+      field[4] = '\0';
+      put(cpu_column, field);
+      field[0] = thread.state;
+      field[1] = '\0';
+      put(state_column, field);
+      put(time_column,
+          Format::ElapsedTime(thread.time, field, sizeof(field)));
+      put(name_column, thread.name);
+      put(command_column, thread.command.c_str());
+    }
+    DrawText(window, ++row, 1, line);
+  }
+}
+
+// The windows both views draw in, and the keys they share.
+struct Screen {
+  explicit Screen(ProcessTable::Column column);
+  ~Screen();
+  void Place();
+  bool Handle(int key, size_t total);
+  void Draw(const Frame& frame, const char* title = nullptr);
+
+  int n{0};  // process rows, as many as the terminal has room for
+  // Rank of the first process row; scrolled with the arrow and page keys.
+  size_t offset{0};
+  ProcessTable::Column sort;
+  bool threads{false};  // threads of the busiest processes instead
+  WINDOW* system_window{nullptr};
+  WINDOW* disk_window{nullptr};
+  WINDOW* network_window{nullptr};
+  WINDOW* process_window{nullptr};
+};
+
+Screen::Screen(ProcessTable::Column column) : sort(column) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  Place();
+  keypad(stdscr, true);  // deliver arrow, page and resize keys
+  timeout(kKeyWait);
+}
 
-  int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
+Screen::~Screen() { endwin(); }
 
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
+// (Re)create the windows for the size of the terminal. The disk and
+// network panels sit on top of each other next to the system window if
+// there is room, under it otherwise: side by side if both fit across,
+// else one above the other. Where that would leave fewer than
+// kMinProcessRows process rows, they are left out.
+void Screen::Place() {
+  for (WINDOW* window :
+       {system_window, disk_window, network_window, process_window}) {
+    if (window != nullptr) {
+      delwin(window);
+    }
+  }
+  disk_window = network_window = nullptr;
+  int width = getmaxx(stdscr) - 1;
+  int lines = getmaxy(stdscr);
+  int top{kSystemHeight};
+  auto fits = [&](int panels) {
+    return lines - top - panels >= 3 + kMinProcessRows;
+  };
+  if (width >= kSystemWidth + kPanelWidth) {
+    int panel = width - kSystemWidth;
+    system_window = newwin(kSystemHeight, kSystemWidth, 0, 0);
+    disk_window = newwin(kPanelHeight, panel, 0, kSystemWidth);
+    network_window = newwin(kSystemHeight - kPanelHeight, panel,
+                            kPanelHeight, kSystemWidth);
+  } else if (width >= 2 * kPanelWidth && fits(kPanelHeight)) {
+    int half = width / 2;
+    system_window = newwin(kSystemHeight, width, 0, 0);
+    disk_window = newwin(kPanelHeight, half, top, 0);
+    network_window = newwin(kPanelHeight, width - half, top, half);
+    top += kPanelHeight;
+  } else if (fits(2 * kPanelHeight)) {
+    system_window = newwin(kSystemHeight, width, 0, 0);
+    disk_window = newwin(kPanelHeight, width, top, 0);
+    network_window = newwin(kPanelHeight, width, top + kPanelHeight, 0);
+    top += 2 * kPanelHeight;
+  } else {
+    system_window = newwin(kSystemHeight, width, 0, 0);
+  }
+  // The rest of the terminal, but at least a heading between borders.
+  int height = std::max(lines - top, 3);
+  top = std::max(std::min(top, lines - height), 0);
+  process_window = newwin(height, width, top, 0);
+  n = height - 3;
+}
+
+// Scroll, sort or resize for key, with total processes to scroll over.
+// True if the screen needs drawing again.
+bool Screen::Handle(int key, size_t total) {
+  size_t last = total > (size_t)n ? total - n : 0;
+  if (key == KEY_DOWN) {
+    offset = std::min(offset + 1, last);
+  } else if (key == KEY_UP) {
+    offset = offset > 0 ? offset - 1 : 0;
+  } else if (key == KEY_NPAGE) {
+    offset = std::min(offset + n, last);
+  } else if (key == KEY_PPAGE) {
+    offset = offset > (size_t)n ? offset - n : 0;
+  } else if (key == KEY_HOME) {
+    offset = 0;
+  } else if (key == 'p') {
+    sort = ProcessTable::kPid;
+  } else if (key == 'u') {
+    sort = ProcessTable::kUser;
+  } else if (key == 'c') {
+    sort = ProcessTable::kCpu;
+  } else if (key == 'm') {
+    sort = ProcessTable::kRam;
+  } else if (key == 't') {
+    sort = ProcessTable::kUpTime;
+  } else if (key == 'r') {
+    sort = ProcessTable::kRead;
+  } else if (key == 'w') {
+    sort = ProcessTable::kWrite;
+  } else if (key == KEY_RESIZE) {
+    clear();
     refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    Place();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Every window, with title on the top border if there is one.
+void Screen::Draw(const Frame& frame, const char* title) {
+  box(system_window, 0, 0);
+  box(process_window, 0, 0);
+  if (title != nullptr) {
+    mvwaddstr(system_window, 0, 2, title);
   }
-  endwin();
-}
\ No newline at end of file
+  NCursesDisplay::DisplaySystem(frame, system_window);
+  if (disk_window != nullptr) {
+    box(disk_window, 0, 0);
+    box(network_window, 0, 0);
+    NCursesDisplay::DisplayDisks(frame, disk_window);
+    NCursesDisplay::DisplayNetwork(frame, network_window);
+    wnoutrefresh(disk_window);
+    wnoutrefresh(network_window);
+  }
+  if (threads) {
+    NCursesDisplay::DisplayThreads(frame, process_window, n, offset);
+  } else {
+    NCursesDisplay::DisplayProcesses(frame, process_window, n, offset);
+  }
+  // All windows go out to the terminal in one write.
+  wnoutrefresh(system_window);
+  wnoutrefresh(process_window);
+  doupdate();
+}
+
+// Draw from frames the sampler thread publishes; this thread only waits
+// for keys and picks up new frames in between, so neither a slow scan
+// nor a key press holds up the other.
+void NCursesDisplay::Display(System& system,
+                             std::chrono::milliseconds interval,
+                             size_t history) {
+  Screen screen(system.SortColumn());
+  Sampler sampler(system, interval, history);
+  sampler.Request(screen.sort, screen.n);
+  bool ready{false};  // the first frame has arrived
+  while (1) {
+    bool redraw = sampler.Poll();
+    ready = ready || redraw;
+    int key = getch();
+    if (key == 'q') {
+      break;
+    }
+    size_t offset = screen.offset;
+    int n = screen.n;
+    ProcessTable::Column sort = screen.sort;
+    bool threads = screen.threads;
+    if (key == 'H') {
+      // Drill into the threads of the busiest processes, or back out.
+      screen.threads = !screen.threads;
+      screen.offset = 0;
+      werase(screen.process_window);
+      redraw = true;
+    }
+    const Frame& front = sampler.Front();
+    size_t total = screen.threads ? front.thread_count : front.processes;
+    redraw = screen.Handle(key, total) || redraw;
+    // Only the rows on screen and those above them need ranking.
+    if (screen.offset != offset || screen.n != n || screen.sort != sort ||
+        screen.threads != threads) {
+      sampler.Request(screen.sort, screen.offset + screen.n, screen.threads);
+    }
+    if (ready && redraw) {
+      screen.Draw(sampler.Front());
+    }
+  }
+}
+
+// Show the ticks of a log, from tick on, with the same views as the live
+// display. Left and right step a tick, < and > a minute's worth, g and G
+// go to the first and last, space plays ten ticks a second.
+void NCursesDisplay::Scrub(MetricsLog::Reader& log, size_t tick) {
+  const size_t jump{60};
+  const auto step = std::chrono::milliseconds(100);
+  size_t last = log.Ticks() - 1;
+  tick = std::min(tick, last);
+  Screen screen(ProcessTable::kCpu);
+  Frame frame;
+  bool playing{false};
+  auto next = std::chrono::steady_clock::now();
+  bool redraw{true};
+  while (1) {
+    int key = getch();
+    size_t previous = tick;
+    if (key == 'q') {
+      break;
+    } else if (key == KEY_RIGHT) {
+      tick = std::min(tick + 1, last);
+    } else if (key == KEY_LEFT) {
+      tick = tick > 0 ? tick - 1 : 0;
+    } else if (key == '>') {
+      tick = std::min(tick + jump, last);
+    } else if (key == '<') {
+      tick = tick > jump ? tick - jump : 0;
+    } else if (key == 'g') {
+      tick = 0;
+    } else if (key == 'G') {
+      tick = last;
+    } else if (key == ' ') {
+      playing = !playing;
+      next = std::chrono::steady_clock::now();
+      redraw = true;
+    }
+    if (playing && std::chrono::steady_clock::now() >= next) {
+      tick = std::min(tick + 1, last);
+      playing = tick < last;
+      next += step;
+    }
+    redraw = screen.Handle(key, frame.processes) || tick != previous ||
+             redraw;
+    if (!redraw) {
+      continue;
+    }
+    redraw = false;
+    if (!log.Read(tick, screen.sort, screen.offset + screen.n, frame)) {
+      continue;
+    }
+    time_t seconds = std::chrono::system_clock::to_time_t(frame.time);
+    tm local;
+    localtime_r(&seconds, &local);
+    char time[32];
+    strftime(time, sizeof(time), "%Y-%m-%d %H:%M:%S", &local);
+    char title[96];
+    snprintf(title, sizeof(title), " %s  tick %zu/%zu%s ", time, tick + 1,
+             last + 1, playing ? "  playing" : "");
+    screen.Draw(frame, title);
+  }
+}
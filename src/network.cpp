@@ -0,0 +1,48 @@
+#include <vector>
+
+#include "counter_deltas.h"
+#include "network.h"
+#include "system_snapshot.h"
+
+using Deltas = CounterDeltas<InterfaceCounters, InterfaceLoad>;
+
+// What one interface did between the before and now counters.
+static void Derive(InterfaceLoad& load, const InterfaceCounters& now,
+                   const InterfaceCounters& before, float seconds) {
+  load.receive_rate =
+      Deltas::Rate(now.receive_bytes, before.receive_bytes, seconds);
+  load.transmit_rate =
+      Deltas::Rate(now.transmit_bytes, before.transmit_bytes, seconds);
+  load.receive_packet_rate =
+      Deltas::Rate(now.receive_packets, before.receive_packets, seconds);
+  load.transmit_packet_rate =
+      Deltas::Rate(now.transmit_packets, before.transmit_packets, seconds);
+  load.drop_rate =
+      Deltas::Rate(now.receive_drops, before.receive_drops, seconds) +
+      Deltas::Rate(now.transmit_drops, before.transmit_drops, seconds);
+}
+
+// Take the interface and TCP counters from this tick's snapshot.
+void Network::Update(const SystemSnapshot& snapshot) {
+  deltas_.Update(snapshot.interfaces, snapshot.uptime_ticks, Derive);
+  // On the first tick the previous counters are zero and the interval is
+  // the uptime, so this is the average since boot.
+  float seconds = deltas_.Interval();
+  long sent = snapshot.tcp_out_segments - previous_out_segments_;
+  long resent = snapshot.tcp_retransmits - previous_retransmits_;
+  retransmit_rate_ =
+      seconds > 0 ? Deltas::Rate(snapshot.tcp_retransmits,
+                                 previous_retransmits_, seconds)
+                  : 0;
+  retransmit_share_ = sent > 0 && resent > 0 ? (float)resent / sent : 0;
+  previous_out_segments_ = snapshot.tcp_out_segments;
+  previous_retransmits_ = snapshot.tcp_retransmits;
+}
+
+const std::vector<InterfaceLoad>& Network::Loads() const {
+  return deltas_.Loads();
+}
+
+float Network::RetransmitRate() const { return retransmit_rate_; }
+
+float Network::RetransmitShare() const { return retransmit_share_; }
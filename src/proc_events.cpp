@@ -0,0 +1,205 @@
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "proc_events.h"
+
+// How long to wait for the kernel to confirm the subscription.
+static const int kAckWait{500};  // ms
+
+// Large enough for a burst of events: each takes under 100 bytes.
+static const int kReceiveBuffer{4 << 20};
+
+// Open the connector, join its multicast group and ask for events.
+// The kernel acknowledges the request with an error code; it does not
+// answer at all inside a user or pid namespace, where no events come.
+ProcEvents::ProcEvents() {
+  if (!Subscribe()) {
+    if (socket_ >= 0) {
+      close(socket_);
+    }
+    socket_ = -1;
+    return;
+  }
+  wake_ = eventfd(0, EFD_CLOEXEC);
+  thread_ = std::thread(&ProcEvents::Run, this);
+}
+
+ProcEvents::~ProcEvents() {
+  if (thread_.joinable()) {
+    uint64_t one{1};
+    if (write(wake_, &one, sizeof(one)) == sizeof(one)) {
+      thread_.join();
+    } else {
+      thread_.detach();
+    }
+  }
+  if (wake_ >= 0) {
+    close(wake_);
+  }
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+bool ProcEvents::Active() const { return socket_ >= 0; }
+
+bool ProcEvents::Subscribe() {
+  socket_ = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (socket_ < 0) {
+    return false;
+  }
+  setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &kReceiveBuffer,
+             sizeof(kReceiveBuffer));
+  sockaddr_nl address{};
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = CN_IDX_PROC;
+  if (bind(socket_, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0) {
+    return false;
+  }
+
+  // A netlink header, a connector header and the operation.
+  alignas(nlmsghdr) char request[NLMSG_SPACE(sizeof(cn_msg) +
+                                             sizeof(proc_cn_mcast_op))]{};
+  nlmsghdr* header = reinterpret_cast<nlmsghdr*>(request);
+  header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+  header->nlmsg_type = NLMSG_DONE;
+  header->nlmsg_pid = getpid();
+  cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+  message->id.idx = CN_IDX_PROC;
+  message->id.val = CN_VAL_PROC;
+  message->len = sizeof(proc_cn_mcast_op);
+  proc_cn_mcast_op operation = PROC_CN_MCAST_LISTEN;
+  memcpy(message->data, &operation, sizeof(operation));
+  if (send(socket_, request, header->nlmsg_len, 0) < 0) {
+    return false;
+  }
+
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(kAckWait);
+  int ack{-1};
+  while (ack < 0) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    pollfd ready{socket_, POLLIN, 0};
+    if (left.count() <= 0 || poll(&ready, 1, left.count()) <= 0 ||
+        !Receive(&ack)) {
+      return false;
+    }
+  }
+  return ack == 0;
+}
+
+// Read one datagram and apply its events. ack receives the error code of
+// an acknowledgement, if there is one. False if the socket has failed.
+bool ProcEvents::Receive(int* ack) {
+  alignas(nlmsghdr) char buffer[64 * 1024];
+  ssize_t size = recv(socket_, buffer, sizeof(buffer), 0);
+  if (size < 0) {
+    if (errno == ENOBUFS) {
+      // The socket overflowed: the events lost cannot be told apart.
+      std::lock_guard<std::mutex> lock(mutex_);
+      lost_ = true;
+      return true;
+    }
+    return errno == EINTR || errno == EAGAIN;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+  for (int left = size; NLMSG_OK(header, left);
+       header = NLMSG_NEXT(header, left)) {
+    if (header->nlmsg_type == NLMSG_ERROR ||
+        header->nlmsg_type == NLMSG_NOOP) {
+      continue;
+    }
+    cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+    if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC) {
+      continue;
+    }
+    proc_event* event = reinterpret_cast<proc_event*>(message->data);
+    switch (event->what) {
+      case proc_event::PROC_EVENT_NONE:
+        if (ack != nullptr) {
+          *ack = event->event_data.ack.err;
+        }
+        break;
+      case proc_event::PROC_EVENT_FORK:
+        // A new thread shares its tgid with the process that made it.
+        if (event->event_data.fork.child_pid ==
+            event->event_data.fork.child_tgid) {
+          started_.insert(event->event_data.fork.child_tgid);
+        }
+        break;
+      case proc_event::PROC_EVENT_EXEC:
+        execed_.push_back(event->event_data.exec.process_tgid);
+        break;
+      case proc_event::PROC_EVENT_EXIT:
+        if (event->event_data.exit.process_pid ==
+            event->event_data.exit.process_tgid) {
+          int pid = event->event_data.exit.process_tgid;
+          if (started_.erase(pid) > 0) {
+            ++short_lived_;
+          } else {
+            exited_.push_back(pid);
+          }
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+// Receive events until the destructor signals wake_. Should the socket
+// fail, Drain() reports lost events from then on.
+void ProcEvents::Run() {
+  pollfd ready[] = {{socket_, POLLIN, 0}, {wake_, POLLIN, 0}};
+  while (true) {
+    if (poll(ready, 2, -1) < 0 && errno != EINTR) {
+      break;
+    }
+    if (ready[1].revents != 0) {
+      return;
+    }
+    if (ready[0].revents != 0 && !Receive(nullptr)) {
+      break;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  failed_ = true;
+}
+
+// Hand over what happened since the last call. changes keeps its
+// capacity from call to call.
+void ProcEvents::Drain(Changes& changes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    changes.started.assign(started_.begin(), started_.end());
+    started_.clear();
+    changes.exited.swap(exited_);
+    exited_.clear();
+    changes.execed.swap(execed_);
+    execed_.clear();
+    changes.short_lived = short_lived_;
+    short_lived_ = 0;
+    changes.lost = lost_ || failed_;
+    lost_ = false;
+  }
+  for (std::vector<int>* pids :
+       {&changes.started, &changes.exited, &changes.execed}) {
+    std::sort(pids->begin(), pids->end());
+    pids->erase(std::unique(pids->begin(), pids->end()), pids->end());
+  }
+}
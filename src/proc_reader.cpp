@@ -0,0 +1,149 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+using std::string_view;
+
+// Number of files opened since start-up.
+// Lets the display show how many opens one refresh costs.
+static std::atomic<long> file_opens{0};
+// open, pread, close and getdents64 calls since start-up, for benchmarks.
+static std::atomic<long> syscalls{0};
+
+static void CountSyscall() { ProcReader::CountSyscalls(1); }
+
+void ProcReader::CountSyscalls(long count) {
+  syscalls.fetch_add(count, std::memory_order_relaxed);
+}
+
+long ProcReader::Opens() { return file_opens.load(); }
+
+long ProcReader::Syscalls() { return syscalls.load(); }
+
+// open(2) the path and count it.
+int ProcReader::Open(const char* path, int flags) {
+  ++file_opens;
+  CountSyscall();
+  return open(path, flags | O_CLOEXEC);
+}
+
+void ProcReader::Close(int fd) {
+  CountSyscall();
+  close(fd);
+}
+
+// getdents64(2) the next entries of the directory fd into buffer.
+long ProcReader::ReadDirectory(int fd, char* buffer, size_t size) {
+  CountSyscall();
+  return syscall(SYS_getdents64, fd, buffer, size);
+}
+
+// Read the whole file from offset 0 into this thread's buffer.
+// The buffer only grows, so in steady state reading allocates nothing.
+// Empty when the read fails, e.g. with ESRCH for an exited process.
+string_view ProcReader::ReadFd(int fd) {
+  thread_local std::vector<char> buffer(4096);
+  size_t size = 0;
+  while (true) {
+    if (size == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+    CountSyscall();
+    ssize_t count =
+        pread(fd, buffer.data() + size, buffer.size() - size, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0) {
+      return {};
+    }
+    if (count == 0) {
+      break;
+    }
+    size += count;
+  }
+  return string_view(buffer.data(), size);
+}
+
+// Open, read and close path.
+string_view ProcReader::Read(const char* path) {
+  int fd = Open(path, O_RDONLY);
+  if (fd < 0) {
+    return {};
+  }
+  string_view text = ReadFd(fd);
+  Close(fd);
+  return text;
+}
+
+// Read /proc/<pid>/<filename>, building the path on the stack.
+string_view ProcReader::ReadPid(int pid, const char* filename) {
+  char path[PATH_MAX];
+  snprintf(path, sizeof(path), "%s%d%s", LinuxParser::ProcDirectory().c_str(),
+           pid, filename);
+  return Read(path);
+}
+
+// Remove and return the first line of text, without its newline.
+string_view ProcReader::NextLine(string_view& text) {
+  size_t end = text.find('\n');
+  string_view line = text.substr(0, end);
+  text.remove_prefix(end == string_view::npos ? text.size() : end + 1);
+  return line;
+}
+
+// Remove and return the first whitespace separated token of text.
+string_view ProcReader::NextToken(string_view& text) {
+  size_t begin = text.find_first_not_of(" \t\n");
+  if (begin == string_view::npos) {
+    text = {};
+    return {};
+  }
+  text.remove_prefix(begin);
+  size_t end = text.find_first_of(" \t\n");
+  string_view token = text.substr(0, end);
+  text.remove_prefix(token.size());
+  return token;
+}
+
+void ProcReader::SkipTokens(string_view& text, int count) {
+  for (int i = 0; i < count; ++i) {
+    NextToken(text);
+  }
+}
+
+// Return the rest of the first line that starts with key,
+// e.g. Value(status, "VmSize:") -> "  123 kB". Empty if there is none.
+string_view ProcReader::Value(string_view text, string_view key) {
+  while (!text.empty()) {
+    string_view line = NextLine(text);
+    if (line.substr(0, key.size()) == key) {
+      return line.substr(key.size());
+    }
+  }
+  return {};
+}
+
+// Parse the leading integer of token, 0 if there is none.
+long ProcReader::ParseLong(string_view token) {
+  long value{0};
+  std::from_chars(token.data(), token.data() + token.size(), value);
+  return value;
+}
+
+// Parse the leading decimal number of token, 0 if there is none.
+double ProcReader::ParseDouble(string_view token) {
+  double value{0};
+  std::from_chars(token.data(), token.data() + token.size(), value);
+  return value;
+}
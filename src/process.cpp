@@ -1,55 +1,50 @@
-#include <unistd.h>
-#include <cctype>
-#include <iostream>
-#include <sstream>
+#include <cstdint>
 #include <string>
-#include <vector>
 
 #include "linux_parser.h"
 #include "process.h"
+#include "process_table.h"
 
 using std::string;
-using std::vector;
-
-// Set the pid for the process
-// pid will be used to gather other information related to the Process.
-void Process::setPid(int pid) {
-  pid_ = pid;
-  user_ = LinuxParser::User(pid);
-  command_ = LinuxParser::Command(pid);
-  cpuUtilization_ = LinuxParser::CpuUtilization(pid);
-  ram_ = LinuxParser::Ram(pid);
-  uptime_ = LinuxParser::UpTime(pid);
-}
+
+Process::Process(ProcessTable* table, std::uint32_t row)
+    : table_(table), row_(row) {}
 
 // Done: Return this process's ID
-int Process::Pid() const { return pid_; }
+int Process::Pid() const { return table_->Pid(row_); }
 
 // Done: Return this process's CPU utilization
-float Process::CpuUtilization() const { return cpuUtilization_; }
+float Process::CpuUtilization() const { return table_->Cpu(row_); }
 
 // Done: Return the command that generated this process
-string Process::Command() const { return command_; }
+const string& Process::Command() const { return table_->Command(row_); }
 
 // Done: Return this process's memory utilization
-string Process::Ram() const { return ram_; }
+long Process::Ram() const { return table_->Ram(row_); }
+
+float Process::ReadRate() const { return table_->ReadRate(row_); }
+
+float Process::WriteRate() const { return table_->WriteRate(row_); }
 
 // Done: Return the user (name) that generated this process
-string Process::User() const { return user_; }
+string Process::User() const {
+  int uid = table_->Uid(row_);
+  if (uid < 0) {
+    return string();
+  }
+  return LinuxParser::UserName(uid);
+}
 
 // Done: Return the age of this process (in seconds)
-long int Process::UpTime() const { return uptime_; }
+long int Process::UpTime() const { return table_->UpTime(row_); }
+
+long Process::StartTime() const { return table_->StartTime(row_); }
 
 /* Overload the "less than" comparison operator for Process objects
  *  Use CPU Utilization.
- *  Future: allow choosing CPU / Memory for sort.
+ *  Other columns: see ProcessTable::Rank().
  */
 bool Process::operator<(Process const& other) const {
-  /* in case we want to sort by memory use.
-  long aMemory = std::stol(this->Ram());
-  long bMemory = std::stol(other.Ram());
-  return aMemory < bMemory;
-  */
   // sort by CPU Utilization.
   return this->CpuUtilization() < other.CpuUtilization();
-}
\ No newline at end of file
+}
@@ -0,0 +1,409 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "linux_parser.h"
+#include "process_table.h"
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+
+size_t ProcessTable::Size() const { return pid_.size(); }
+
+long ProcessTable::Find(int pid) const {
+  auto found = rows_.find(pid);
+  return found == rows_.end() ? -1 : (long)found->second;
+}
+
+// Add a row for a process, or reset the row of a pid that now belongs
+// to a different process.
+uint32_t ProcessTable::Insert(int pid, long starttime) {
+  auto found = rows_.find(pid);
+  uint32_t row;
+  if (found != rows_.end()) {
+    row = found->second;
+    Forget(row, kLoadedCommand);
+  } else {
+    row = pid_.size();
+    rows_.emplace(pid, row);
+    pid_.emplace_back();
+    starttime_.emplace_back();
+    last_seen_.emplace_back();
+    hidden_.emplace_back();
+    loaded_.emplace_back();
+    cpu_.emplace_back();
+    prev_active_.emplace_back();
+    prev_total_.emplace_back();
+    ram_.emplace_back();
+    uptime_.emplace_back();
+    read_rate_.emplace_back();
+    write_rate_.emplace_back();
+    read_bytes_.emplace_back();
+    write_bytes_.emplace_back();
+    io_time_.emplace_back();
+    uid_.emplace_back();
+    command_.emplace_back();
+  }
+  pid_[row] = pid;
+  starttime_[row] = starttime;
+  last_seen_[row] = 0;
+  hidden_[row] = 0;
+  loaded_[row] = 0;
+  cpu_[row] = 0;
+  prev_active_[row] = 0;
+  prev_total_[row] = 0;
+  ram_[row] = 0;
+  uptime_[row] = 0;
+  read_rate_[row] = -1;
+  write_rate_[row] = -1;
+  read_bytes_[row] = 0;
+  write_bytes_[row] = 0;
+  io_time_[row] = 0;
+  uid_[row] = -1;
+  command_[row] = 0;
+  return row;
+}
+
+// Remove the row of pid by moving the last row into its place.
+void ProcessTable::Erase(int pid) {
+  auto found = rows_.find(pid);
+  if (found == rows_.end()) {
+    return;
+  }
+  uint32_t row = found->second;
+  uint32_t last = pid_.size() - 1;
+  Forget(row, kLoadedCommand);
+  rows_.erase(found);
+  if (row != last) {
+    rows_[pid_[last]] = row;
+    pid_[row] = pid_[last];
+    starttime_[row] = starttime_[last];
+    last_seen_[row] = last_seen_[last];
+    hidden_[row] = hidden_[last];
+    loaded_[row] = loaded_[last];
+    cpu_[row] = cpu_[last];
+    prev_active_[row] = prev_active_[last];
+    prev_total_[row] = prev_total_[last];
+    ram_[row] = ram_[last];
+    uptime_[row] = uptime_[last];
+    read_rate_[row] = read_rate_[last];
+    write_rate_[row] = write_rate_[last];
+    read_bytes_[row] = read_bytes_[last];
+    write_bytes_[row] = write_bytes_[last];
+    io_time_[row] = io_time_[last];
+    uid_[row] = uid_[last];
+    command_[row] = command_[last];
+  }
+  pid_.pop_back();
+  starttime_.pop_back();
+  last_seen_.pop_back();
+  hidden_.pop_back();
+  loaded_.pop_back();
+  cpu_.pop_back();
+  prev_active_.pop_back();
+  prev_total_.pop_back();
+  ram_.pop_back();
+  uptime_.pop_back();
+  read_rate_.pop_back();
+  write_rate_.pop_back();
+  read_bytes_.pop_back();
+  write_bytes_.pop_back();
+  io_time_.pop_back();
+  uid_.pop_back();
+  command_.pop_back();
+}
+
+// Refresh the counters that change from tick to tick.
+void ProcessTable::Update(uint32_t row, const LinuxParser::ProcessStat& stat,
+                          const SystemSnapshot& snapshot, long tick) {
+  int hertz = sysconf(_SC_CLK_TCK);
+  long active = stat.utime + stat.stime;
+  long total = snapshot.cpu.Total();
+  if (last_seen_[row] == 0) {
+    // First sample: nothing to compare against yet. The process's
+    // average since it started would say nothing about now, so it shows
+    // no load until the next tick.
+    cpu_[row] = 0;
+  } else {
+    long elapsed = total - prev_total_[row];
+    if (elapsed > 0) {
+      cpu_[row] = std::clamp(
+          (float)(active - prev_active_[row]) / elapsed, 0.0f, 1.0f);
+    }
+  }
+  prev_active_[row] = active;
+  prev_total_[row] = total;
+  loaded_[row] &= ~(kLoadedRam | kLoadedIo);
+  hidden_[row] = LinuxParser::IsKernelThread(stat) || stat.state == 'Z';
+  uptime_[row] =
+      (stat.utime + stat.stime + stat.cutime + stat.cstime) / hertz;
+  last_seen_[row] = tick;
+}
+
+// Rows worth showing: seen in this tick's scan, not a kernel thread or
+// zombie.
+bool ProcessTable::Visible(uint32_t row, long tick) const {
+  return last_seen_[row] == tick && !hidden_[row];
+}
+
+// Pair each visible row with its key, read straight from one column.
+template <typename T>
+void ProcessTable::RankBy(const std::vector<T>& column, bool descending,
+                          long tick) {
+  ranking_.clear();
+  for (uint32_t row = 0; row < column.size(); ++row) {
+    if (Visible(row, tick)) {
+      double key = column[row];
+      ranking_.emplace_back(descending ? -key : key, row);
+    }
+  }
+}
+
+// Rank by user name: the distinct uids of the visible rows are put in
+// order of their names once, and each row is keyed by the place of its
+// uid. Rows whose uid is unknown come last.
+void ProcessTable::RankByUser(long tick) {
+  user_ranks_.clear();
+  for (uint32_t row = 0; row < pid_.size(); ++row) {
+    if (Visible(row, tick) && uid_[row] >= 0) {
+      user_ranks_.emplace_back(uid_[row], 0);
+    }
+  }
+  std::sort(user_ranks_.begin(), user_ranks_.end());
+  user_ranks_.erase(std::unique(user_ranks_.begin(), user_ranks_.end()),
+                    user_ranks_.end());
+  user_names_.resize(user_ranks_.size());
+  for (size_t i = 0; i < user_ranks_.size(); ++i) {
+    user_names_[i].first = LinuxParser::UserName(user_ranks_[i].first);
+    user_names_[i].second = i;
+  }
+  std::sort(user_names_.begin(), user_names_.end());
+  for (size_t i = 0; i < user_names_.size(); ++i) {
+    user_ranks_[user_names_[i].second].second = i;
+  }
+  ranking_.clear();
+  for (uint32_t row = 0; row < pid_.size(); ++row) {
+    if (!Visible(row, tick)) {
+      continue;
+    }
+    auto found = std::lower_bound(
+        user_ranks_.begin(), user_ranks_.end(), uid_[row],
+        [](const std::pair<int, uint32_t>& a, int uid) {
+          return a.first < uid;
+        });
+    double key = uid_[row] >= 0 ? found->second : user_ranks_.size();
+    ranking_.emplace_back(key, row);
+  }
+}
+
+// Fill rows with the count visible rows that come first by column:
+// largest CPU, memory, time and I/O, smallest pid, user name in order,
+// ties by pid.
+// nth_element
+// picks them in linear time and only those get sorted, so showing the top
+// rows costs O(n + count log count) instead of a full sort.
+// Ranking by memory or user reads status for every row that lacks it,
+// ranking by I/O reads io.
+void ProcessTable::Rank(Column column, size_t count, long tick,
+                        std::vector<uint32_t>& rows) {
+  if (column == kRam || column == kUser) {
+    Field field = column == kRam ? kLoadedRam : kLoadedUid;
+    for (uint32_t row = 0; row < pid_.size(); ++row) {
+      if (Visible(row, tick) && !Loaded(row, field)) {
+        LoadStatus(row);
+      }
+    }
+  }
+  if (column == kRead || column == kWrite) {
+    for (uint32_t row = 0; row < pid_.size(); ++row) {
+      if (Visible(row, tick) && !Loaded(row, kLoadedIo)) {
+        LoadIo(row);
+      }
+    }
+  }
+  switch (column) {
+    case kPid:
+      RankBy(pid_, false, tick);
+      break;
+    case kUser:
+      RankByUser(tick);
+      break;
+    case kCpu:
+      RankBy(cpu_, true, tick);
+      break;
+    case kRam:
+      RankBy(ram_, true, tick);
+      break;
+    case kUpTime:
+      RankBy(uptime_, true, tick);
+      break;
+    case kRead:
+      RankBy(read_rate_, true, tick);
+      break;
+    case kWrite:
+      RankBy(write_rate_, true, tick);
+      break;
+  }
+  // Equal keys go by pid, as in the log view, so ties keep their order
+  // however Erase() has moved the rows around.
+  auto before = [this](const std::pair<double, uint32_t>& a,
+                       const std::pair<double, uint32_t>& b) {
+    if (a.first != b.first) {
+      return a.first < b.first;
+    }
+    return pid_[a.second] < pid_[b.second];
+  };
+  count = std::min(count, ranking_.size());
+  if (count < ranking_.size()) {
+    std::nth_element(ranking_.begin(), ranking_.begin() + count,
+                     ranking_.end(), before);
+  }
+  std::sort(ranking_.begin(), ranking_.begin() + count, before);
+  rows.clear();
+  for (size_t i = 0; i < count; ++i) {
+    rows.push_back(ranking_[i].second);
+  }
+}
+
+int ProcessTable::Pid(uint32_t row) const { return pid_[row]; }
+
+// Start time in clock ticks after boot
+long ProcessTable::StartTime(uint32_t row) const { return starttime_[row]; }
+
+// Share of all cores used since the previous Update()
+float ProcessTable::Cpu(uint32_t row) const { return cpu_[row]; }
+
+// CPU time in seconds, children included
+long ProcessTable::UpTime(uint32_t row) const { return uptime_[row]; }
+
+// Whether field holds a current value, i.e. its accessor will not read.
+bool ProcessTable::Loaded(uint32_t row, Field field) const {
+  return loaded_[row] & field;
+}
+
+void ProcessTable::Forget(uint32_t row, Field field) {
+  if (field & kLoadedCommand && Loaded(row, kLoadedCommand)) {
+    Release(command_[row]);
+  }
+  loaded_[row] &= ~field;
+}
+
+int ProcessTable::Uid(uint32_t row) {
+  if (!Loaded(row, kLoadedUid)) {
+    LoadStatus(row);
+  }
+  return uid_[row];
+}
+
+long ProcessTable::Ram(uint32_t row) {
+  if (!Loaded(row, kLoadedRam)) {
+    LoadStatus(row);
+  }
+  return ram_[row];
+}
+
+float ProcessTable::ReadRate(uint32_t row) {
+  if (!Loaded(row, kLoadedIo)) {
+    LoadIo(row);
+  }
+  return read_rate_[row];
+}
+
+float ProcessTable::WriteRate(uint32_t row) {
+  if (!Loaded(row, kLoadedIo)) {
+    LoadIo(row);
+  }
+  return write_rate_[row];
+}
+
+const string& ProcessTable::Command(uint32_t row) {
+  if (!Loaded(row, kLoadedCommand)) {
+    command_[row] = Intern(LinuxParser::Command(pid_[row]));
+    loaded_[row] |= kLoadedCommand;
+  }
+  return strings_[command_[row]];
+}
+
+// Fill whichever of memory and uid are missing with one read of
+// /proc/[pid]/status.
+void ProcessTable::LoadStatus(uint32_t row) {
+  unsigned mask{0};
+  if (!Loaded(row, kLoadedRam)) {
+    mask |= LinuxParser::kStatusVmRss;
+  }
+  if (!Loaded(row, kLoadedUid)) {
+    mask |= LinuxParser::kStatusUid;
+  }
+  LinuxParser::ProcessStatus status;
+  bool alive = LinuxParser::Status(pid_[row], mask, status);
+  if (!Loaded(row, kLoadedRam)) {
+    ram_[row] = status.vm_rss;
+    loaded_[row] |= kLoadedRam;
+  }
+  if (!Loaded(row, kLoadedUid) && alive) {
+    uid_[row] = status.uid;
+    loaded_[row] |= kLoadedUid;
+  }
+}
+
+// Storage bytes per second since the previous read of /proc/[pid]/io.
+void ProcessTable::LoadIo(uint32_t row) {
+  loaded_[row] |= kLoadedIo;
+  LinuxParser::ProcessIo io;
+  if (!LinuxParser::Io(pid_[row], io)) {
+    read_rate_[row] = write_rate_[row] = -1;
+    io_time_[row] = 0;
+    return;
+  }
+  double now = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+  double elapsed = now - io_time_[row];
+  if (io_time_[row] == 0) {
+    read_rate_[row] = write_rate_[row] = 0;
+  } else if (elapsed > 0) {
+    read_rate_[row] =
+        std::max<long>(io.read_bytes - read_bytes_[row], 0) / elapsed;
+    write_rate_[row] =
+        std::max<long>(io.write_bytes - write_bytes_[row], 0) / elapsed;
+  }
+  read_bytes_[row] = io.read_bytes;
+  write_bytes_[row] = io.write_bytes;
+  io_time_[row] = now;
+}
+
+// Index of text in the string pool, adding it on first use. A string no
+// row uses any more gives its slot to the next new one, so the pool is
+// as large as the distinct commands running, however many exec()s came
+// and went.
+uint32_t ProcessTable::Intern(std::string_view text) {
+  auto found = interned_.find(text);
+  if (found != interned_.end()) {
+    ++references_[found->second];
+    return found->second;
+  }
+  uint32_t index;
+  if (!free_.empty()) {
+    index = free_.back();
+    free_.pop_back();
+    strings_[index].assign(text);
+  } else {
+    index = strings_.size();
+    strings_.emplace_back(text);
+    references_.emplace_back();
+  }
+  references_[index] = 1;
+  interned_.emplace(strings_[index], index);
+  return index;
+}
+
+// Drop one use of an interned string.
+void ProcessTable::Release(uint32_t index) {
+  if (--references_[index] == 0) {
+    interned_.erase(strings_[index]);
+    free_.push_back(index);
+  }
+}
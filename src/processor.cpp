@@ -1,6 +1,47 @@
 #include "processor.h"
-#include <iostream>
 #include "linux_parser.h"
+#include "system_snapshot.h"
+
+using namespace LinuxParser;
+
+// Work out the load since the previous counters and keep the new ones.
+// The first tick compares against zero, i.e. the average since boot.
+void Processor::Advance(Sample& sample, const CpuTimes& current) {
+  const CpuTimes& previous = sample.previous;
+  long total = current.Total() - previous.Total();
+  if (total > 0) {
+    auto share = [&](long delta) { return (float)delta / (float)total; };
+    long idle = current.Idle() - previous.Idle();
+    CpuLoad& load = sample.load;
+    load.utilization = share(total - idle);
+    load.user = share(current.times[kUser_] + current.times[kNice_] -
+                      previous.times[kUser_] - previous.times[kNice_]);
+    load.system = share(current.times[kSystem_] + current.times[kIRQ_] +
+                        current.times[kSoftIRQ_] - previous.times[kSystem_] -
+                        previous.times[kIRQ_] - previous.times[kSoftIRQ_]);
+    load.iowait = share(current.times[kIOwait_] - previous.times[kIOwait_]);
+    load.steal = share(current.times[kSteal_] - previous.times[kSteal_]);
+  }
+  sample.previous = current;
+}
+
+// Take the CPU counters from this tick's snapshot.
+void Processor::Update(const SystemSnapshot& snapshot) {
+  Advance(cpu_, snapshot.cpu);
+  if (cores_.size() != snapshot.cores.size()) {
+    cores_.resize(snapshot.cores.size());
+  }
+  for (size_t core = 0; core < cores_.size(); ++core) {
+    Advance(cores_[core], snapshot.cores[core]);
+  }
+}
 
 // Done: Return the aggregate CPU utilization
-float Processor::Utilization() { return LinuxParser::CpuUtilization(); }
\ No newline at end of file
+float Processor::Utilization() { return cpu_.load.utilization; }
+
+// Aggregate utilization split by state.
+const CpuLoad& Processor::Load() const { return cpu_.load; }
+
+int Processor::Cores() const { return cores_.size(); }
+
+const CpuLoad& Processor::Core(int core) const { return cores_[core].load; }
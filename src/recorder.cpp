@@ -0,0 +1,121 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+#include "recorder.h"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::string_view;
+using std::vector;
+
+// Write text to path, replacing what was there.
+static bool Write(const string& path, string_view text) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  while (!text.empty()) {
+    ssize_t written = write(fd, text.data(), text.size());
+    if (written <= 0) {
+      close(fd);
+      return false;
+    }
+    text.remove_prefix(written);
+  }
+  return close(fd) == 0;
+}
+
+// Copy the live file at path to the same path under root.
+// False, and nothing written, if it cannot be read or is empty.
+static bool Copy(const string& root, const string& path) {
+  string_view text = ProcReader::Read(path.c_str());
+  return !text.empty() && Write(root + path, text);
+}
+
+// Copy one tick of the live system into root.
+static bool Snapshot(const string& root) {
+  using namespace LinuxParser;
+  std::error_code error;
+  fs::create_directories(root + kProcDirectory + "/net", error);
+  fs::create_directories(fs::path(root + kOSPath).parent_path(), error);
+  if (error) {
+    return false;
+  }
+  const string proc = kProcDirectory;
+  // What a replayed tick cannot do without.
+  bool copied = Copy(root, proc + kStatFilename) &&
+                Copy(root, proc + kMeminfoFilename) &&
+                Copy(root, proc + kUptimeFilename) &&
+                Copy(root, proc + kVersionFilename);
+  if (!copied) {
+    return false;
+  }
+  // Not in every container; a replay without them shows no OS name,
+  // user ids for names, or no disks and interfaces.
+  Copy(root, kOSPath);
+  Copy(root, kPasswordPath);
+  Copy(root, proc + kDiskstatsFilename);
+  Copy(root, proc + kNetDevFilename);
+  Copy(root, proc + kSnmpFilename);
+  for (int pid : Pids()) {
+    string directory = proc + std::to_string(pid);
+    string_view stat = ProcReader::Read((directory + kStatFilename).c_str());
+    // Gone since Pids(): leave it out rather than record it half.
+    if (stat.empty() || !fs::create_directory(root + directory, error)) {
+      continue;
+    }
+    Write(root + directory + kStatFilename, stat);
+    Copy(root, directory + kStatusFilename);
+    Copy(root, directory + kCmdlineFilename);
+    // Only the owner and root may read it; record none rather than empty.
+    string_view io = ProcReader::Read((directory + kIoFilename).c_str());
+    if (!io.empty()) {
+      Write(root + directory + kIoFilename, io);
+    }
+  }
+  return true;
+}
+
+// Record ticks snapshots of the live system into dir, one per interval.
+bool Recorder::Record(const string& dir, int ticks,
+                      std::chrono::milliseconds interval) {
+  if (!LinuxParser::Root().empty()) {
+    return false;
+  }
+  auto next = std::chrono::steady_clock::now();
+  for (int tick = 0; tick < ticks; ++tick) {
+    char name[16];
+    snprintf(name, sizeof(name), "/%06d", tick);
+    if (!Snapshot(dir + name)) {
+      return false;
+    }
+    if (tick + 1 < ticks) {
+      next += interval;
+      std::this_thread::sleep_until(next);
+    }
+  }
+  return true;
+}
+
+// Tick directories of a recording, in the order they were taken.
+vector<string> Recorder::Ticks(const string& dir) {
+  vector<string> ticks;
+  std::error_code error;
+  for (const auto& entry : fs::directory_iterator(dir, error)) {
+    if (entry.is_directory()) {
+      ticks.push_back(entry.path().string());
+    }
+  }
+  std::sort(ticks.begin(), ticks.end());
+  return ticks;
+}
@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+
+#include "sampler.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Processes whose threads are listed when they are asked for.
+static const std::size_t kDrillProcesses{8};
+
+Sampler::Sampler(System& system, std::chrono::milliseconds interval,
+                 std::size_t history)
+    : system_(system),
+      interval_(interval),
+      history_(history),
+      sort_(system.SortColumn()),
+      thread_(&Sampler::Run, this) {}
+
+Sampler::~Sampler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+// Rank by sort and keep the first rows processes in every Frame, and as
+// many threads if threads is set.
+void Sampler::Request(ProcessTable::Column sort, std::size_t rows,
+                      bool threads) {
+  sort_ = sort;
+  rows_ = rows;
+  threads_ = threads;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requested_ = true;
+  }
+  wake_.notify_one();
+}
+
+bool Sampler::Poll() { return frames_.Update(); }
+
+const Frame& Sampler::Front() const { return frames_.Front(); }
+
+// Scan on every tick of the grid; in between, only re-rank on request.
+// Threads are read on every tick while they are shown, and at once when
+// they are first asked for.
+void Sampler::Run() {
+  auto next = Clock::now();
+  std::chrono::system_clock::time_point scanned;
+  bool drilled{false};
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    bool tick = Clock::now() >= next;
+    requested_ = false;
+    lock.unlock();
+    Frame& frame = frames_.Back();
+    if (tick) {
+      scanned = std::chrono::system_clock::now();
+      system_.Refresh();
+      system_.Processes();
+      history_.Record(scanned, system_);
+    }
+    bool threads = threads_;
+    if (threads && (tick || !drilled)) {
+      system_.CollectThreads(kDrillProcesses);
+    }
+    drilled = threads;
+    frame.time = scanned;
+    system_.SortBy(static_cast<ProcessTable::Column>(sort_.load()));
+    frame.Capture(system_, history_, rows_, threads);
+    frames_.Publish();
+    lock.lock();
+    if (tick) {
+      next += interval_;
+      // Skip the ticks a long scan ran over; stay on the grid.
+      auto now = Clock::now();
+      if (next <= now) {
+        next += (now - next) / interval_ * interval_ + interval_;
+      }
+    }
+    wake_.wait_until(lock, next, [this] { return stop_ || requested_; });
+  }
+}
@@ -1,6 +1,10 @@
 #include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <cstddef>
 #include <iostream>
+#include <iterator>
 #include <set>
 #include <string>
 #include <vector>
@@ -15,55 +19,290 @@ using std::size_t;
 using std::string;
 using std::vector;
 
+// Pids collected by one task of the thread pool.
+static const size_t kChunkSize{128};
+
+// While events are watched, /proc is still listed on the first tick and
+// every this many ticks after it, to catch anything they missed.
+static const long kReconcile{30};
+
 // Assign a CPU to the System Object
-System::System() {
+// threads: number of threads that collect processes in parallel.
+System::System(int threads) : pool_(threads) {
   Processor aCPU;
   cpu_ = aCPU;
+  fresh_.resize(pool_.Size());
+  stats_.assign(pool_.Size(),
+                vector<LinuxParser::ProcessStat>(kChunkSize));
+  collector_ = Collector::Make(Collector::kProcfs, pool_.Size());
+  Refresh();
+  ReadRelease();
+}
+
+// The OS and kernel do not change while the monitor runs; read them once
+// per root.
+void System::ReadRelease() {
+  operating_system_ = LinuxParser::OperatingSystem();
+  kernel_ = LinuxParser::Kernel();
 }
 
+// Drive the monitor from recorded tick directories instead of the live
+// system. Each Refresh() moves to the next one and stays at the last:
+// starting over would run the counters backwards. The password file is
+// read from the first tick only.
+void System::Replay(vector<string> ticks) {
+  replay_ = std::move(ticks);
+  replay_tick_ = 0;
+  if (!replay_.empty()) {
+    LinuxParser::SetRoot(replay_.front());
+  }
+  Refresh();
+  ReadRelease();
+}
+
+// Follow forks and exits through the proc connector, so that the pid
+// list is kept from tick to tick instead of listing /proc each time, and
+// processes too short for any scan to see are counted. False if the
+// connector is unavailable (it needs root); then /proc is listed as
+// before.
+bool System::WatchEvents() {
+  events_ = std::make_unique<ProcEvents>();
+  if (!events_->Active()) {
+    events_.reset();
+    return false;
+  }
+  return true;
+}
+
+// Take the counters of each process from kind instead of
+// /proc/<pid>/stat. False if it cannot be used here (taskstats needs
+// CAP_NET_ADMIN); then the collector stays as it was.
+bool System::UseCollector(Collector::Kind kind) {
+  std::unique_ptr<Collector> collector = Collector::Make(kind, pool_.Size());
+  if (!collector) {
+    return false;
+  }
+  collector_ = std::move(collector);
+  return true;
+}
+
+const char* System::CollectorName() const { return collector_->Name(); }
+
+// Read the system wide files of SystemSnapshot once for this tick.
+// Every system wide getter below answers from this snapshot.
+void System::Refresh() {
+  if (replay_tick_ < replay_.size()) {
+    LinuxParser::SetRoot(replay_[replay_tick_++], false);
+  }
+  long opens = LinuxParser::FileOpens();
+  opens_per_tick_ = opens - opens_at_refresh_;
+  opens_at_refresh_ = opens;
+  snapshot_.Refresh();
+  cpu_.Update(snapshot_);
+  disks_.Update(snapshot_);
+  network_.Update(snapshot_);
+}
+
+const SystemSnapshot& System::Snapshot() const { return snapshot_; }
+
+// Files opened between the last two calls to Refresh()
+long System::OpensPerTick() const { return opens_per_tick_; }
+
+// Seconds spent in the last call to Processes()
+double System::CollectionTime() const { return collection_time_; }
+
+int System::Threads() const { return pool_.Size(); }
+
+// Processes that appeared since the previous call to Processes(); 0
+// after the first.
+int System::Started() const { return started_.size(); }
+
+// Processes that exited since the previous call to Processes()
+int System::Exited() const { return exited_.size(); }
+
+// Processes that started and exited since the previous call to
+// Processes(); -1 unless events are watched.
+int System::ShortLived() const {
+  return events_ ? changes_.short_lived : -1;
+}
+
+// Processes the last call to Processes() returned
+size_t System::Visible() const { return processes_.size(); }
+
 // Done: Return the system's CPU
 Processor& System::Cpu() { return cpu_; }
 
+// Throughput and latency of each disk over the last interval
+const vector<DiskLoad>& System::DiskLoads() const { return disks_.Loads(); }
+
+// Throughput of each interface and TCP retransmits over the last interval
+const Network& System::Net() const { return network_; }
+
 // Done: Return a container composed of the system's processes
+// The list is not ordered; Top() ranks it.
+// The table survives between ticks: a process seen before only has its
+// counters refreshed, a new one (or a reused pid) gets a fresh row.
 vector<Process>& System::Processes() {
-  // place holder variable for each process in the int vector of pids.
-  Process temporaryProcess;
-  // clear out the old list.
+  auto start = std::chrono::steady_clock::now();
+  ++tick_;
+  LinuxParser::RevalidateUsers();
+  // get Pids from the LinuxParser, sorted, and diff them against the
+  // previous tick's to find the processes that have exited.
+  // With events, the previous tick's pids with the exits taken out and
+  // the forks added are the same list, short of a reconcile tick or
+  // events the kernel dropped.
+  bool scan{true};
+  if (events_) {
+    events_->Drain(changes_);
+    scan = changes_.lost || tick_ % kReconcile == 1;
+    if (!scan) {
+      survivors_.clear();
+      std::set_difference(previous_pids_.begin(), previous_pids_.end(),
+                          changes_.exited.begin(), changes_.exited.end(),
+                          std::back_inserter(survivors_));
+      pids_.clear();
+      std::set_union(survivors_.begin(), survivors_.end(),
+                     changes_.started.begin(), changes_.started.end(),
+                     std::back_inserter(pids_));
+    }
+    // A new program means a new command line, and maybe a new user.
+    for (int pid : changes_.execed) {
+      long row = table_.Find(pid);
+      if (row >= 0) {
+        table_.Forget(row, ProcessTable::kLoadedCommand);
+        table_.Forget(row, ProcessTable::kLoadedUid);
+      }
+    }
+  }
+  if (scan) {
+    LinuxParser::Pids(pids_, true);
+  }
+  started_.clear();
+  exited_.clear();
+  // The first scan has nothing to diff against; every process it finds
+  // was already running.
+  if (tick_ > 1) {
+    std::set_difference(pids_.begin(), pids_.end(), previous_pids_.begin(),
+                        previous_pids_.end(), std::back_inserter(started_));
+  }
+  std::set_difference(previous_pids_.begin(), previous_pids_.end(),
+                      pids_.begin(), pids_.end(), std::back_inserter(exited_));
+  for (int pid : exited_) {
+    LinuxParser::Release(pid);
+    table_.Erase(pid);
+  }
+
+  // collect them in parallel.
+  for (vector<Fresh>& fresh : fresh_) {
+    fresh.clear();
+  }
+  pool_.ParallelFor(
+      (pids_.size() + kChunkSize - 1) / kChunkSize,
+      [this](size_t chunk, int worker) { Collect(chunk, worker); });
+  for (vector<Fresh>& fresh : fresh_) {
+    for (const Fresh& process : fresh) {
+      std::uint32_t row =
+          table_.Insert(process.first, process.second.starttime);
+      table_.Update(row, process.second, snapshot_, tick_);
+    }
+  }
+
+  previous_pids_.swap(pids_);
+
+  // Rows listed but gone before their stat could be read drop out of the
+  // table with the next diff. Kernel threads and zombies have no command
+  // line, and the stat flags tell them apart without reading it. Don't
+  // show either.
   processes_.clear();
-  // get Pids from the LinuxParser and iterate.
-  vector<int> procIds = LinuxParser::Pids();
-  for (int pid : procIds) {
-    temporaryProcess.setPid(pid);
-    // Rare case where there is an entry in /proc for a process,
-    // but no command can be found in /proc/<pid>/cmdline.
-    // Don't show these in our monitor.
-    if (temporaryProcess.Command() != "None") {
-      processes_.push_back(temporaryProcess);
+  for (std::uint32_t row = 0; row < table_.Size(); ++row) {
+    if (table_.Visible(row, tick_)) {
+      processes_.emplace_back(&table_, row);
     }
   }
 
-  // Showing processes with Largest CPU utilization at the top of the list.
-  // so sort in reverse order.
-  // std::reverse did not appear to work in the Udacity Workspace.
-  // using sort with rbegin and rend works.
-  sort(processes_.rbegin(), processes_.rend());
+  collection_time_ = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
   return processes_;
 }
 
+// Return the first count processes in the order of SortBy(), by default
+// largest CPU utilization first. See ProcessTable::Rank().
+const vector<Process>& System::Top(size_t count) { return Top(count, sort_); }
+
+// The same, ranked by column whatever SortBy() chose.
+const vector<Process>& System::Top(size_t count, ProcessTable::Column column) {
+  table_.Rank(column, count, tick_, ranked_);
+  top_.clear();
+  for (std::uint32_t row : ranked_) {
+    top_.emplace_back(&table_, row);
+  }
+  return top_;
+}
+
+// Read the threads of the processes busiest by CPU, at most processes
+// of them. Processes() must have run for this tick.
+void System::CollectThreads(size_t processes) {
+  top_threads_.Collect(Top(processes, ProcessTable::kCpu), pool_, snapshot_);
+}
+
+const ThreadTable& System::TopThreads() const { return top_threads_; }
+
+// Choose the column Top() ranks by.
+void System::SortBy(ProcessTable::Column column) { sort_ = column; }
+
+ProcessTable::Column System::SortColumn() const { return sort_; }
+
+// Collect one chunk of pids_ on a worker thread.
+// Rows already in the table are only touched by the worker that owns
+// their pid, and rows are not added or removed until every worker has
+// finished, so no locking is needed.
+void System::Collect(size_t chunk, int worker) {
+  size_t begin = chunk * kChunkSize;
+  size_t end = std::min(pids_.size(), begin + kChunkSize);
+  vector<LinuxParser::ProcessStat>& stats = stats_[worker];
+  collector_->Stat(&pids_[begin], end - begin, stats.data(), worker);
+  for (size_t i = begin; i < end; ++i) {
+    int pid = pids_[i];
+    const LinuxParser::ProcessStat& stat = stats[i - begin];
+    if (stat.state == 0) {
+      // exited since the directory was listed.
+      continue;
+    }
+    // A pid reused by a new process has a new start time; the collector
+    // says how exact it is.
+    long row = table_.Find(pid);
+    if (row >= 0 && std::labs(table_.StartTime(row) - stat.starttime) <=
+                        collector_->StartTimeSlack()) {
+      table_.Update(row, stat, snapshot_, tick_);
+    } else {
+      fresh_[worker].emplace_back(pid, stat);
+    }
+  }
+}
+
 // Done: Return the system's kernel identifier (string)
-std::string System::Kernel() { return LinuxParser::Kernel(); }
+const std::string& System::Kernel() const { return kernel_; }
 
 // Done: Return the system's memory utilization
-float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+// Based on HTOP method. Total used memory = MemTotal - MemFree
+float System::MemoryUtilization() {
+  if (snapshot_.mem_total == 0) {
+    return 0.0;
+  }
+  return (snapshot_.mem_total - snapshot_.mem_free) / snapshot_.mem_total;
+}
 
 // Done: Return the operating system name
-std::string System::OperatingSystem() { return LinuxParser::OperatingSystem(); }
+const std::string& System::OperatingSystem() const {
+  return operating_system_;
+}
 
 // Done: Return the number of processes actively running on the system
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return snapshot_.running_processes; }
 
 // Done: Return the total number of processes on the system
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return snapshot_.total_processes; }
 
 // Done: Return the number of seconds since the system started running
-long int System::UpTime() { return LinuxParser::UpTime(); }
\ No newline at end of file
+long int System::UpTime() { return snapshot_.uptime; }
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include <unistd.h>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+#include "system_snapshot.h"
+
+using LinuxParser::Path;
+using ProcReader::NextLine;
+using ProcReader::NextToken;
+using ProcReader::ParseLong;
+using ProcReader::SkipTokens;
+using std::string;
+using std::string_view;
+
+long CpuTimes::Total() const {
+  using namespace LinuxParser;
+  return times[kUser_] + times[kNice_] + times[kSystem_] + times[kIdle_] +
+         times[kIOwait_] + times[kIRQ_] + times[kSoftIRQ_] + times[kSteal_];
+}
+
+long CpuTimes::Idle() const {
+  return times[LinuxParser::kIdle_] + times[LinuxParser::kIOwait_];
+}
+
+// Read the counters following the "cpu" key of a /proc/stat line.
+static void ReadCpuTimes(string_view& line, CpuTimes& cpu) {
+  for (long& time : cpu.times) {
+    time = ParseLong(NextToken(line));
+  }
+}
+
+// Whether a /proc/diskstats name is a partition of one of the first
+// count disks, which are listed before their partitions: sda1 of sda,
+// nvme0n1p1 of nvme0n1. As the kernel names them, a disk whose name ends
+// in a digit has a 'p' before the partition number, so nvme0n10 is a
+// disk of its own rather than partition 0 of nvme0n1.
+static bool IsPartition(string_view name,
+                        const std::vector<DiskCounters>& disks,
+                        size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    string_view parent = disks[i].name;
+    if (parent.empty() || name.size() <= parent.size() ||
+        name.substr(0, parent.size()) != parent) {
+      continue;
+    }
+    string_view number = name.substr(parent.size());
+    if (parent.back() >= '0' && parent.back() <= '9') {
+      if (number.front() != 'p') {
+        continue;
+      }
+      number.remove_prefix(1);
+    }
+    if (!number.empty() &&
+        number.find_first_not_of("0123456789") == string_view::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Whole devices of /proc/diskstats that have seen any I/O. Loop and RAM
+// disks are left out, as are partitions, whose I/O their device counts.
+// disks only grows when a device shows up for the first time.
+static void ReadDisks(std::vector<DiskCounters>& disks) {
+  const string& path = Path(LinuxParser::kDiskstatsFile);
+  string_view diskstats = ProcReader::Read(path.c_str());
+  size_t count{0};
+  while (!diskstats.empty()) {
+    string_view line = NextLine(diskstats);
+    SkipTokens(line, 2);  // major and minor number
+    string_view name = NextToken(line);
+    if (name.empty() || name.substr(0, 4) == "loop" ||
+        name.substr(0, 3) == "ram" || IsPartition(name, disks, count)) {
+      continue;
+    }
+    DiskCounters disk;
+    name.copy(disk.name, sizeof(disk.name) - 1);
+    disk.reads = ParseLong(NextToken(line));
+    SkipTokens(line, 1);  // merged
+    disk.sectors_read = ParseLong(NextToken(line));
+    disk.read_ms = ParseLong(NextToken(line));
+    disk.writes = ParseLong(NextToken(line));
+    SkipTokens(line, 1);  // merged
+    disk.sectors_written = ParseLong(NextToken(line));
+    disk.write_ms = ParseLong(NextToken(line));
+    SkipTokens(line, 1);  // in flight
+    disk.io_ms = ParseLong(NextToken(line));
+    if (disk.reads == 0 && disk.writes == 0) {
+      continue;
+    }
+    if (count == disks.size()) {
+      disks.emplace_back();
+    }
+    disks[count++] = disk;
+  }
+  disks.resize(count);
+}
+
+// Interfaces of /proc/net/dev that have moved any bytes. A name is
+// followed by a colon, with no space before a large first counter.
+// interfaces only grows when one shows up for the first time.
+static void ReadInterfaces(std::vector<InterfaceCounters>& interfaces) {
+  const string& path = Path(LinuxParser::kNetDevFile);
+  string_view dev = ProcReader::Read(path.c_str());
+  NextLine(dev);  // two lines of headings
+  NextLine(dev);
+  size_t count{0};
+  while (!dev.empty()) {
+    string_view line = NextLine(dev);
+    size_t colon = line.find(':');
+    if (colon == string_view::npos) {
+      continue;
+    }
+    string_view name = line.substr(0, colon);
+    name = NextToken(name);
+    line.remove_prefix(colon + 1);
+    InterfaceCounters interface;
+    name.copy(interface.name, sizeof(interface.name) - 1);
+    interface.receive_bytes = ParseLong(NextToken(line));
+    interface.receive_packets = ParseLong(NextToken(line));
+    SkipTokens(line, 1);  // errors
+    interface.receive_drops = ParseLong(NextToken(line));
+    SkipTokens(line, 4);  // fifo, frame, compressed, multicast
+    interface.transmit_bytes = ParseLong(NextToken(line));
+    interface.transmit_packets = ParseLong(NextToken(line));
+    SkipTokens(line, 1);  // errors
+    interface.transmit_drops = ParseLong(NextToken(line));
+    if (interface.receive_bytes == 0 && interface.transmit_bytes == 0) {
+      continue;
+    }
+    if (count == interfaces.size()) {
+      interfaces.emplace_back();
+    }
+    interfaces[count++] = interface;
+  }
+  interfaces.resize(count);
+}
+
+// OutSegs and RetransSegs of /proc/net/snmp, where a line of names
+// precedes each line of values.
+static void ReadTcp(long& out_segments, long& retransmits) {
+  const string& path = Path(LinuxParser::kSnmpFile);
+  string_view snmp = ProcReader::Read(path.c_str());
+  out_segments = retransmits = 0;
+  while (!snmp.empty()) {
+    string_view names = NextLine(snmp);
+    if (NextToken(names) != "Tcp:") {
+      continue;
+    }
+    string_view values = NextLine(snmp);
+    NextToken(values);
+    while (!names.empty()) {
+      string_view name = NextToken(names);
+      string_view value = NextToken(values);
+      if (name == "OutSegs") {
+        out_segments = ParseLong(value);
+      } else if (name == "RetransSegs") {
+        retransmits = ParseLong(value);
+      }
+    }
+    return;
+  }
+}
+
+// Read /proc/stat, /proc/meminfo, /proc/uptime, /proc/diskstats,
+// /proc/net/dev and /proc/net/snmp, one open each.
+void SystemSnapshot::Refresh() {
+  size_t core{0};
+  string_view stat = ProcReader::Read(Path(LinuxParser::kStatFile).c_str());
+  while (!stat.empty()) {
+    string_view line = NextLine(stat);
+    string_view key = NextToken(line);
+    if (key == "cpu") {
+      ReadCpuTimes(line, cpu);
+    } else if (key.substr(0, 3) == "cpu") {
+      // Per core lines come in order, cpu0 .. cpuN.
+      // Only grows when a core shows up for the first time.
+      if (core == cores.size()) {
+        cores.emplace_back();
+      }
+      ReadCpuTimes(line, cores[core++]);
+    } else if (key == "processes") {
+      total_processes = ParseLong(NextToken(line));
+    } else if (key == "procs_running") {
+      running_processes = ParseLong(NextToken(line));
+    }
+  }
+  cores.resize(core);
+
+  const string& meminfo_path = Path(LinuxParser::kMeminfoFile);
+  string_view meminfo = ProcReader::Read(meminfo_path.c_str());
+  while (!meminfo.empty()) {
+    string_view line = NextLine(meminfo);
+    string_view key = NextToken(line);
+    if (key == "MemTotal:") {
+      mem_total = ParseLong(NextToken(line));
+    } else if (key == "MemFree:") {
+      mem_free = ParseLong(NextToken(line));
+    }
+  }
+
+  const string& uptime_path = Path(LinuxParser::kUptimeFile);
+  string_view uptime_file = ProcReader::Read(uptime_path.c_str());
+  double seconds = ProcReader::ParseDouble(NextToken(uptime_file));
+  uptime = static_cast<long>(seconds);
+  uptime_ticks = static_cast<long>(seconds * sysconf(_SC_CLK_TCK));
+
+  ReadDisks(disks);
+  ReadInterfaces(interfaces);
+  ReadTcp(tcp_out_segments, tcp_retransmits);
+}
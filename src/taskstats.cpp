@@ -0,0 +1,264 @@
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+#include "taskstats.h"
+
+using std::size_t;
+using std::uint32_t;
+
+// Processes per sendto/recvmmsg pair. Their replies must fit in the
+// socket's receive buffer, or the kernel drops the rest.
+static const size_t kBatch{32};
+// Room for one reply: headers and a struct taskstats, which grows a
+// little with every kernel version.
+static const size_t kReplySize{2048};
+static const int kReceiveBuffer{1 << 20};
+
+// TASKSTATS_CMD_GET for one id.
+struct Request {
+  nlmsghdr header;
+  genlmsghdr command;
+  nlattr attribute;
+  uint32_t id;
+};
+static_assert(sizeof(Request) ==
+                  NLMSG_LENGTH(GENL_HDRLEN + NLA_HDRLEN + sizeof(uint32_t)),
+              "requests are packed back to back");
+
+// Attributes from the start of payload up to end, one after another.
+template <typename Visit>
+static void Attributes(const char* payload, const char* end, Visit visit) {
+  while (payload + NLA_HDRLEN <= end) {
+    const nlattr* attribute = reinterpret_cast<const nlattr*>(payload);
+    if (attribute->nla_len < NLA_HDRLEN ||
+        payload + attribute->nla_len > end) {
+      return;
+    }
+    visit(attribute->nla_type & NLA_TYPE_MASK, payload + NLA_HDRLEN,
+          payload + attribute->nla_len);
+    payload += NLA_ALIGN(attribute->nla_len);
+  }
+}
+
+// Generic netlink id of the taskstats family, 0 if there is none.
+static int Family(int socket) {
+  struct {
+    nlmsghdr header;
+    genlmsghdr command;
+    nlattr attribute;
+    char name[16];
+  } request{};
+  request.header.nlmsg_len = sizeof(request);
+  request.header.nlmsg_type = GENL_ID_CTRL;
+  request.header.nlmsg_flags = NLM_F_REQUEST;
+  request.command.cmd = CTRL_CMD_GETFAMILY;
+  request.command.version = 1;
+  request.attribute.nla_type = CTRL_ATTR_FAMILY_NAME;
+  request.attribute.nla_len = NLA_HDRLEN + sizeof(TASKSTATS_GENL_NAME);
+  memcpy(request.name, TASKSTATS_GENL_NAME, sizeof(TASKSTATS_GENL_NAME));
+  if (send(socket, &request, sizeof(request), 0) < 0) {
+    return 0;
+  }
+  alignas(nlmsghdr) char reply[8192];
+  ssize_t size = recv(socket, reply, sizeof(reply), 0);
+  const nlmsghdr* header = reinterpret_cast<const nlmsghdr*>(reply);
+  if (size < (ssize_t)NLMSG_LENGTH(GENL_HDRLEN) ||
+      header->nlmsg_type != GENL_ID_CTRL) {
+    return 0;
+  }
+  int family{0};
+  const char* payload =
+      static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+  Attributes(payload, reply + std::min<size_t>(size, header->nlmsg_len),
+             [&](int type, const char* value, const char*) {
+               if (type == CTRL_ATTR_FAMILY_ID) {
+                 uint16_t id;
+                 memcpy(&id, value, sizeof(id));
+                 family = id;
+               }
+             });
+  return family;
+}
+
+// One socket per worker; taskstats is then asked about our own process
+// to find out whether we may ask at all.
+std::unique_ptr<TaskstatsCollector> TaskstatsCollector::Make(int workers) {
+  std::unique_ptr<TaskstatsCollector> collector(new TaskstatsCollector());
+  collector->hertz_ = sysconf(_SC_CLK_TCK);
+  collector->channels_.resize(std::max(workers, 1));
+  for (Channel& channel : collector->channels_) {
+    channel.socket =
+        socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (channel.socket < 0) {
+      return nullptr;
+    }
+    setsockopt(channel.socket, SOL_SOCKET, SO_RCVBUF, &kReceiveBuffer,
+               sizeof(kReceiveBuffer));
+    channel.requests.resize(2 * kBatch * sizeof(Request));
+    channel.replies.resize(2 * kBatch * kReplySize);
+    channel.headers.resize(2 * kBatch);
+    channel.vectors.resize(2 * kBatch);
+    for (size_t i = 0; i < 2 * kBatch; ++i) {
+      channel.vectors[i] = {&channel.replies[i * kReplySize], kReplySize};
+      channel.headers[i] = {};
+      channel.headers[i].msg_hdr.msg_iov = &channel.vectors[i];
+      channel.headers[i].msg_hdr.msg_iovlen = 1;
+    }
+  }
+  collector->family_ = Family(collector->channels_[0].socket);
+  if (collector->family_ == 0) {
+    return nullptr;
+  }
+  int self = getpid();
+  Record record;
+  collector->ReadBatch(collector->channels_[0], &self, 1, &record);
+  if (!record.found) {
+    return nullptr;  // EPERM without CAP_NET_ADMIN
+  }
+  collector->records_.resize(collector->channels_.size() * kBatch);
+  return collector;
+}
+
+TaskstatsCollector::~TaskstatsCollector() {
+  for (Channel& channel : channels_) {
+    if (channel.socket >= 0) {
+      close(channel.socket);
+    }
+  }
+}
+
+const char* TaskstatsCollector::Name() const { return "taskstats"; }
+
+// The start time comes in microseconds and is rounded down to clock
+// ticks, which may land a tick off the one procfs computes.
+long TaskstatsCollector::StartTimeSlack() const { return 1; }
+
+// Up to kBatch processes: a request by tgid and one by pid for each,
+// sent together, replies matched back by sequence number.
+void TaskstatsCollector::ReadBatch(Channel& channel, const int* pids,
+                                   size_t count, Record* records) {
+  Request* requests = reinterpret_cast<Request*>(channel.requests.data());
+  for (size_t i = 0; i < 2 * count; ++i) {
+    Request& request = requests[i];
+    request = {};
+    request.header.nlmsg_len = sizeof(Request);
+    request.header.nlmsg_type = family_;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.header.nlmsg_seq = i;
+    request.command.cmd = TASKSTATS_CMD_GET;
+    request.command.version = 1;
+    request.attribute.nla_len = NLA_HDRLEN + sizeof(uint32_t);
+    request.attribute.nla_type =
+        i % 2 == 0 ? TASKSTATS_CMD_ATTR_TGID : TASKSTATS_CMD_ATTR_PID;
+    request.id = pids[i / 2];
+  }
+  std::fill(records, records + count, Record{});
+  ProcReader::CountSyscalls(2);
+  if (send(channel.socket, requests, 2 * count * sizeof(Request), 0) < 0) {
+    return;
+  }
+  // Replies are queued before send() returns; take what is there. They
+  // were written within the last moments, so now less a process's
+  // elapsed time is when it started.
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  std::uint64_t uptime = now.tv_sec * 1000000ull + now.tv_nsec / 1000;
+  int received = recvmmsg(channel.socket, channel.headers.data(), 2 * count,
+                          MSG_DONTWAIT, nullptr);
+  std::uint8_t replied[kBatch]{};
+  for (int message = 0; message < received; ++message) {
+    const char* reply = &channel.replies[message * kReplySize];
+    size_t size = std::min<size_t>(channel.headers[message].msg_len,
+                                   kReplySize);
+    const nlmsghdr* header = reinterpret_cast<const nlmsghdr*>(reply);
+    if (size < NLMSG_LENGTH(GENL_HDRLEN) || header->nlmsg_type != family_ ||
+        header->nlmsg_seq >= 2 * count) {
+      continue;  // an error, such as ESRCH for a process that is gone
+    }
+    size_t index = header->nlmsg_seq / 2;
+    bool by_tgid = header->nlmsg_seq % 2 == 0;
+    taskstats stats{};
+    bool found{false};
+    const char* payload =
+        static_cast<const char*>(NLMSG_DATA(header)) + GENL_HDRLEN;
+    const char* end = reply + std::min<size_t>(size, header->nlmsg_len);
+    // An aggregate holds the id and the struct; older or newer kernels
+    // send a shorter or longer struct, of which the common part counts.
+    Attributes(payload, end, [&](int, const char* nested,
+                                 const char* nested_end) {
+      Attributes(nested, nested_end, [&](int type, const char* value,
+                                         const char* value_end) {
+        if (type == TASKSTATS_TYPE_STATS) {
+          memcpy(&stats, value,
+                 std::min<size_t>(value_end - value, sizeof(stats)));
+          found = true;
+        }
+      });
+    });
+    if (!found) {
+      continue;
+    }
+    Record& record = records[index];
+    if (by_tgid) {
+      record.utime = stats.ac_utime;
+      record.stime = stats.ac_stime;
+      record.cpu_delay = stats.cpu_delay_total;
+      record.blkio_delay = stats.blkio_delay_total;
+    } else {
+      record.begin = uptime - std::min<std::uint64_t>(stats.ac_etime,
+                                                      uptime);
+      record.parent = stats.ac_ppid;
+      record.hiwater_rss = stats.hiwater_rss;
+      record.hiwater_vm = stats.hiwater_vm;
+      record.read_bytes = stats.read_bytes;
+      record.write_bytes = stats.write_bytes;
+    }
+    replied[index] |= by_tgid ? 1 : 2;
+    record.found = replied[index] == 3;
+  }
+}
+
+void TaskstatsCollector::Read(const int* pids, size_t count,
+                              Record* records, int worker) {
+  for (size_t first = 0; first < count; first += kBatch) {
+    ReadBatch(channels_[worker], pids + first,
+              std::min(kBatch, count - first), records + first);
+  }
+}
+
+// The records as /proc/<pid>/stat would have them; see the class comment
+// for what taskstats cannot tell.
+void TaskstatsCollector::Stat(const int* pids, size_t count,
+                              LinuxParser::ProcessStat* stats, int worker) {
+  Record* records = &records_[worker * kBatch];
+  for (size_t first = 0; first < count; first += kBatch) {
+    size_t batch = std::min(kBatch, count - first);
+    ReadBatch(channels_[worker], pids + first, batch, records);
+    for (size_t i = 0; i < batch; ++i) {
+      const Record& record = records[i];
+      LinuxParser::ProcessStat& stat = stats[first + i];
+      stat = LinuxParser::ProcessStat{};
+      if (!record.found) {
+        continue;
+      }
+      // kthreadd (pid 2) is the parent of every other kernel thread.
+      bool kernel = pids[first + i] == 2 || record.parent == 2;
+      stat.flags = kernel ? LinuxParser::kPfKthread : 0;
+      stat.state = !kernel && record.hiwater_vm == 0 ? 'Z' : 'S';
+      stat.utime = record.utime * hertz_ / 1000000;
+      stat.stime = record.stime * hertz_ / 1000000;
+      stat.starttime = record.begin * hertz_ / 1000000;
+    }
+  }
+}
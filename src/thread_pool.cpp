@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include "thread_pool.h"
+
+using std::size_t;
+
+ThreadPool::ThreadPool(int threads) {
+  threads = std::max(threads, 1);
+  for (int worker = 0; worker < threads; ++worker) {
+    shares_.push_back(std::make_unique<Share>());
+  }
+  for (int worker = 1; worker < threads; ++worker) {
+    threads_.emplace_back(&ThreadPool::Work, this, worker);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+int ThreadPool::Size() const { return shares_.size(); }
+
+// Run task for every chunk in [0, chunks) and wait for all of them.
+void ThreadPool::ParallelFor(size_t chunks, const Task& task) {
+  size_t workers = shares_.size();
+  for (size_t worker = 0; worker < workers; ++worker) {
+    Share& share = *shares_[worker];
+    std::lock_guard<std::mutex> lock(share.mutex);
+    share.begin = chunks * worker / workers;
+    share.end = chunks * (worker + 1) / workers;
+  }
+  if (threads_.empty()) {
+    task_ = &task;
+    Run(0);
+    task_ = nullptr;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    busy_ = threads_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+  Run(0);
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return busy_ == 0; });
+  task_ = nullptr;
+}
+
+// Background worker: run every job it is woken for.
+void ThreadPool::Work(int worker) {
+  long seen{0};
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+    }
+    Run(worker);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--busy_ == 0) {
+      done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::Run(int worker) {
+  size_t chunk;
+  while (Next(worker, chunk)) {
+    (*task_)(chunk, worker);
+  }
+}
+
+// Take the next chunk from the front of our own share,
+// otherwise steal one from the back of somebody else's.
+bool ThreadPool::Next(int worker, size_t& chunk) {
+  {
+    Share& own = *shares_[worker];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.begin < own.end) {
+      chunk = own.begin++;
+      return true;
+    }
+  }
+  size_t workers = shares_.size();
+  for (size_t offset = 1; offset < workers; ++offset) {
+    Share& victim = *shares_[(worker + offset) % workers];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.begin < victim.end) {
+      chunk = --victim.end;
+      return true;
+    }
+  }
+  return false;
+}
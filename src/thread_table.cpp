@@ -0,0 +1,104 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process.h"
+#include "system_snapshot.h"
+#include "thread_pool.h"
+#include "thread_table.h"
+
+using std::size_t;
+using std::vector;
+
+// Threads read by one task of the thread pool.
+static const size_t kChunkSize{64};
+
+// Read the threads of processes, in two parallel passes: one task per
+// process lists its task directory, then one per chunk of threads reads
+// their stat.
+void ThreadTable::Collect(const vector<Process>& processes, ThreadPool& pool,
+                          const SystemSnapshot& snapshot) {
+  if (tids_.size() < processes.size()) {
+    tids_.resize(processes.size());
+  }
+  pool.ParallelFor(processes.size(), [&](size_t chunk, int) {
+    LinuxParser::Tasks(processes[chunk].Pid(), tids_[chunk]);
+  });
+  // Commands are interned by the process table, which only this thread
+  // may touch.
+  commands_.clear();
+  tasks_.clear();
+  skipped_ = 0;
+  for (size_t i = 0; i < processes.size(); ++i) {
+    commands_.push_back(&processes[i].Command());
+    size_t room = kMaxThreads - tasks_.size();
+    size_t taken = std::min(room, tids_[i].size());
+    for (size_t j = 0; j < taken; ++j) {
+      tasks_.emplace_back(i, tids_[i][j]);
+    }
+    skipped_ += tids_[i].size() - taken;
+  }
+
+  read_.resize(pool.Size());
+  for (vector<Thread>& read : read_) {
+    read.clear();
+  }
+  long total = snapshot.cpu.Total();
+  pool.ParallelFor(
+      (tasks_.size() + kChunkSize - 1) / kChunkSize,
+      [&](size_t chunk, int worker) {
+        size_t end = std::min(tasks_.size(), (chunk + 1) * kChunkSize);
+        LinuxParser::ProcessStat stat;
+        for (size_t i = chunk * kChunkSize; i < end; ++i) {
+          const Process& process = processes[tasks_[i].first];
+          Thread thread;
+          thread.tid = tasks_[i].second;
+          thread.pid = process.Pid();
+          thread.command = commands_[tasks_[i].first];
+          if (!LinuxParser::TaskStat(thread.pid, thread.tid, stat,
+                                     thread.name)) {
+            continue;  // exited since the directory was listed
+          }
+          thread.state = stat.state;
+          thread.starttime = stat.starttime;
+          thread.active = stat.utime + stat.stime;
+          thread.total = total;
+          read_[worker].push_back(thread);
+        }
+      });
+
+  threads_.clear();
+  for (const vector<Thread>& read : read_) {
+    threads_.insert(threads_.end(), read.begin(), read.end());
+  }
+  std::sort(threads_.begin(), threads_.end(),
+            [](const Thread& a, const Thread& b) { return a.tid < b.tid; });
+  for (Thread& thread : threads_) {
+    auto previous = std::lower_bound(
+        previous_.begin(), previous_.end(), thread.tid,
+        [](const Thread& a, int tid) { return a.tid < tid; });
+    thread.cpu = 0;
+    if (previous != previous_.end() && previous->tid == thread.tid &&
+        previous->starttime == thread.starttime) {
+      long active = thread.active - previous->active;
+      long elapsed = total - previous->total;
+      if (elapsed > 0) {
+        thread.cpu = std::clamp((float)active / elapsed, 0.0f, 1.0f);
+      }
+    }
+  }
+  previous_ = threads_;
+  std::stable_sort(threads_.begin(), threads_.end(),
+                   [](const Thread& a, const Thread& b) {
+                     return a.cpu > b.cpu;
+                   });
+}
+
+const vector<ThreadTable::Thread>& ThreadTable::Threads() const {
+  return threads_;
+}
+
+size_t ThreadTable::Skipped() const { return skipped_; }
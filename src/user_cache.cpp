@@ -0,0 +1,107 @@
+#include <pwd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "proc_reader.h"
+#include "user_cache.h"
+
+using std::string;
+
+UserCache::UserCache(string path) : path_(std::move(path)) { Load(); }
+
+// Position of uid in names, or where it would go.
+static auto Find(std::vector<std::pair<int, string>>& names, int uid) {
+  return std::lower_bound(
+      names.begin(), names.end(), uid,
+      [](const std::pair<int, string>& entry, int id) {
+        return entry.first < id;
+      });
+}
+
+// Read every name:password:uid line of the password file. A line whose
+// uid is not a number is skipped rather than taken for root.
+// Expects mutex_ to be held, or the cache not yet shared.
+void UserCache::Load() {
+  struct stat info;
+  if (stat(path_.c_str(), &info) == 0) {
+    mtime_ = info.st_mtim;
+  }
+  names_.clear();
+  std::string_view passwd = ProcReader::Read(path_.c_str());
+  while (!passwd.empty()) {
+    std::string_view line = ProcReader::NextLine(passwd);
+    size_t name_end = line.find(':');
+    size_t uid_begin = line.find(':', name_end + 1);
+    if (name_end == string::npos || uid_begin == string::npos) {
+      continue;
+    }
+    size_t uid_end = line.find(':', uid_begin + 1);
+    if (uid_end == string::npos) {
+      uid_end = line.size();
+    }
+    const char* first = line.data() + uid_begin + 1;
+    const char* last = line.data() + uid_end;
+    int uid;
+    auto [end, error] = std::from_chars(first, last, uid);
+    if (first == last || error != std::errc() || end != last || uid < 0) {
+      continue;
+    }
+    names_.emplace_back(uid, line.substr(0, name_end));
+  }
+  // first entry wins, as with getpwuid.
+  std::stable_sort(names_.begin(), names_.end(),
+                   [](const std::pair<int, string>& a,
+                      const std::pair<int, string>& b) {
+                     return a.first < b.first;
+                   });
+  names_.erase(std::unique(names_.begin(), names_.end(),
+                           [](const std::pair<int, string>& a,
+                              const std::pair<int, string>& b) {
+                             return a.first == b.first;
+                           }),
+               names_.end());
+}
+
+// One stat() of the password file; reload only if it was modified.
+void UserCache::Revalidate() {
+  struct stat info;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stat(path_.c_str(), &info) != 0) {
+    return;
+  }
+  if (info.st_mtim.tv_sec != mtime_.tv_sec ||
+      info.st_mtim.tv_nsec != mtime_.tv_nsec) {
+    Load();
+  }
+}
+
+void UserCache::SetPath(string path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  path_ = std::move(path);
+  Load();
+}
+
+// Return the user name for uid.
+// Falls back to getpwuid_r, and to the number itself when nobody knows it.
+string UserCache::Name(int uid) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = Find(names_, uid);
+  if (entry != names_.end() && entry->first == uid) {
+    return entry->second;
+  }
+  string name = std::to_string(uid);
+  passwd pwd;
+  passwd* result = nullptr;
+  long size = sysconf(_SC_GETPW_R_SIZE_MAX);
+  std::vector<char> buffer(size > 0 ? size : 16384);
+  if (getpwuid_r(uid, &pwd, buffer.data(), buffer.size(), &result) == 0 &&
+      result != nullptr) {
+    name = result->pw_name;
+  }
+  return names_.emplace(entry, uid, name)->second;
+}
@@ -0,0 +1,34 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <iostream>
+
+// Failed checks are printed and counted; a test's main() returns
+// Failures() != 0 so that ctest reports it.
+inline int& Failures() {
+  static int failures{0};
+  return failures;
+}
+
+#define CHECK_EQ(actual, expected)                                       \
+  do {                                                                   \
+    auto&& check_actual = (actual);                                      \
+    auto&& check_expected = (expected);                                  \
+    if (!(check_actual == check_expected)) {                             \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " << #actual        \
+                << " is " << check_actual << ", expected "               \
+                << check_expected << "\n";                               \
+      ++Failures();                                                      \
+    }                                                                    \
+  } while (false)
+
+#define CHECK(condition)                                                 \
+  do {                                                                   \
+    if (!(condition)) {                                                  \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition     \
+                << " is false\n";                                        \
+      ++Failures();                                                      \
+    }                                                                    \
+  } while (false)
+
+#endif
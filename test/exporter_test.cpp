@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "exporter.h"
+#include "linux_parser.h"
+#include "process.h"
+#include "system.h"
+#include "test_root.h"
+
+using std::string;
+using std::vector;
+
+// A command that needs escaping in both formats. The parser keeps
+// argv[0] up to the first space, tab or newline, so a carriage return
+// is the line break that can reach the exporter.
+static const string kCommand = "/opt/a,b\"c\"\\d\re\x01" "f";
+
+// Everything an exporter wrote for one sample of pids 7 and 8, pid 7
+// running kCommand.
+static string Export(Exporter::Format format) {
+  TestRoot root("exporter_test");
+  root.Set(7, 0, 100);
+  root.Set(8, 0, 100);
+  root.Tick();
+  std::ofstream(root.Root() + LinuxParser::kProcDirectory + "7" +
+                LinuxParser::kCmdlineFilename)
+      << kCommand << '\0';
+  LinuxParser::SetRoot(root.Root());
+
+  char path[] = "/tmp/exporter_test.XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  System system(1);
+  Exporter exporter(fd, format);
+  auto time = std::chrono::system_clock::time_point(
+      std::chrono::milliseconds(1700000000123));
+  CHECK(exporter.Write(time, system, system.Processes()));
+  close(fd);
+  LinuxParser::SetRoot("");
+
+  std::ifstream file(path);
+  string text((std::istreambuf_iterator<char>(file)),
+              std::istreambuf_iterator<char>());
+  unlink(path);
+  return text;
+}
+
+// Records of RFC 4180 CSV: quoted fields may hold commas, doubled
+// quotes and line breaks.
+static vector<vector<string>> ParseCsv(const string& text) {
+  vector<vector<string>> records;
+  vector<string> fields;
+  string field;
+  bool quoted = false;
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if (quoted) {
+      if (c != '"') {
+        field += c;
+      } else if (i + 1 < text.size() && text[i + 1] == '"') {
+        field += '"';
+        ++i;
+      } else {
+        quoted = false;
+      }
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      fields.push_back(field);
+      field.clear();
+    } else if (c == '\n') {
+      fields.push_back(field);
+      field.clear();
+      records.push_back(fields);
+      fields.clear();
+    } else {
+      field += c;
+    }
+  }
+  CHECK(!quoted);
+  CHECK(field.empty() && fields.empty());  // ends with a whole record
+  return records;
+}
+
+// One header, and every record has all its columns, whatever the
+// command holds.
+static void WritesCsv() {
+  const vector<string> header = {
+      "type",     "time_ms",  "cpu",     "user",    "system",   "iowait",
+      "steal",    "memory",   "processes", "running", "uptime",
+      "cpu_time", "pid",      "user_name", "ram_kb",  "command"};
+  vector<vector<string>> records = ParseCsv(Export(Exporter::kCsv));
+  CHECK_EQ(records.size(), 4u);  // header, system, two processes
+  if (records.size() != 4) {
+    return;
+  }
+  CHECK(records[0] == header);
+  for (const vector<string>& record : records) {
+    CHECK_EQ(record.size(), header.size());
+  }
+  CHECK_EQ(records[1][0], "system");
+  CHECK_EQ(records[1][1], "1700000000123");
+  CHECK_EQ(records[1][12], "");
+  for (std::size_t i = 2; i < records.size(); ++i) {
+    const vector<string>& record = records[i];
+    if (record.size() != header.size()) {
+      continue;
+    }
+    CHECK_EQ(record[0], "process");
+    CHECK_EQ(record[1], "1700000000123");
+    CHECK_EQ(record[10], "");
+    CHECK_EQ(record[13], "root");
+    CHECK_EQ(record[14], "2000");
+    CHECK_EQ(record[15], record[12] == "7" ? kCommand : "/usr/bin/task8");
+  }
+}
+
+// One record per line: quotes and backslashes are escaped, control
+// characters written as \u00XX.
+static void WritesJson() {
+  string text = Export(Exporter::kJson);
+  vector<string> lines;
+  for (std::size_t begin = 0; begin < text.size();) {
+    std::size_t end = text.find('\n', begin);
+    CHECK(end != string::npos);
+    if (end == string::npos) {
+      break;
+    }
+    lines.push_back(text.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  CHECK_EQ(lines.size(), 3u);
+  if (lines.size() != 3) {
+    return;
+  }
+  CHECK_EQ(lines[0].find("{\"type\":\"system\",\"time_ms\":1700000000123,"),
+           0u);
+  const string command =
+      "\"command\":\"/opt/a,b\\\"c\\\"\\\\d\\u000de\\u0001f\"}";
+  int found = 0;
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    CHECK_EQ(lines[i].find("{\"type\":\"process\""), 0u);
+    if (lines[i].find("\"pid\":7,") != string::npos) {
+      CHECK(lines[i].size() >= command.size() &&
+            lines[i].compare(lines[i].size() - command.size(),
+                             command.size(), command) == 0);
+      ++found;
+    }
+  }
+  CHECK_EQ(found, 1);
+}
+
+int main() {
+  WritesCsv();
+  WritesJson();
+  return Failures() != 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstddef>
+
+#include "check.h"
+#include "history.h"
+#include "linux_parser.h"
+#include "system.h"
+#include "test_root.h"
+
+// Steady processes keep their history when another process enters the
+// top ranks: the newcomer must take the slot of the one that left, not
+// the slot of a steady process that comes after it in the ranking.
+static void NewcomerKeepsSteadySlots() {
+  TestRoot root("history_test");
+  const int kSteady{31};
+  const int kLow{100};
+  const int kNewcomer{200};
+  const int kTicks{10};
+  auto usage = [](int pid, int tick) -> long {
+    if (pid == kNewcomer) {
+      return 90L * (tick - 5);  // busier than every steady process
+    }
+    return pid == kLow ? tick : (2L + pid) * tick;
+  };
+  long start = root.UptimeTicks() - 5000;
+  long newcomer_start = root.UptimeTicks() + 350;  // during tick 4
+  for (int pid = 1; pid <= kSteady; ++pid) {
+    root.Set(pid, usage(pid, 0), start);
+  }
+  root.Set(kLow, usage(kLow, 0), start);
+  root.Tick();
+  LinuxParser::SetRoot(root.Root());
+
+  System system(1);
+  History history(1 << 20, 32);
+  History::Clock::time_point time{};
+  for (int tick = 0; tick < kTicks; ++tick) {
+    if (tick > 0) {
+      for (int pid = 1; pid <= kSteady; ++pid) {
+        root.Set(pid, usage(pid, tick), start);
+      }
+      root.Set(kLow, usage(kLow, tick), start);
+      if (tick >= 5) {
+        root.Set(kNewcomer, usage(kNewcomer, tick), newcomer_start);
+      }
+      root.Tick();
+      system.Refresh();
+    }
+    system.Processes();
+    history.Record(time, system);
+    time += std::chrono::seconds(1);
+  }
+
+  for (int pid = 1; pid <= kSteady; ++pid) {
+    History::Summary range =
+        history.Range(pid, start, std::chrono::minutes(1));
+    CHECK_EQ(range.samples, (std::size_t)kTicks);
+  }
+  // The newcomer took over the slot of the low process, which left the
+  // top ranks when it got busy.
+  std::chrono::minutes minute(1);
+  CHECK_EQ(history.Range(kLow, start, minute).samples, 0u);
+  CHECK_EQ(history.Range(kNewcomer, newcomer_start, minute).samples, 4u);
+  LinuxParser::SetRoot("");
+}
+
+int main() {
+  NewcomerKeepsSteadySlots();
+  return Failures() != 0;
+}
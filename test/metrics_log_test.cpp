@@ -0,0 +1,164 @@
+#include <signal.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "frame.h"
+#include "linux_parser.h"
+#include "metrics_log.h"
+#include "process.h"
+#include "system.h"
+#include "test_root.h"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::vector;
+
+// What a tick should read back as.
+struct Expected {
+  struct Row {
+    int pid;
+    string user;
+    string command;
+    long cpu;  // 1/10000
+    long ram;
+    long uptime;
+  };
+  std::chrono::system_clock::time_point time;
+  int total_processes;
+  int started;
+  int exited;
+  long uptime;
+  vector<Row> rows;  // by pid
+};
+
+static Expected Take(std::chrono::system_clock::time_point time,
+                     System& system) {
+  Expected tick{time,
+                system.TotalProcesses(),
+                system.Started(),
+                system.Exited(),
+                system.UpTime(),
+                {}};
+  for (const Process& process : system.Top(1000, ProcessTable::kPid)) {
+    tick.rows.push_back({process.Pid(), process.User(), process.Command(),
+                         std::lround(process.CpuUtilization() * 10000),
+                         process.Ram(), process.UpTime()});
+  }
+  return tick;
+}
+
+static void Compare(MetricsLog::Reader& reader, std::size_t tick,
+                    const Expected& expected) {
+  Frame frame;
+  CHECK(reader.Read(tick, ProcessTable::kPid, 1000, frame));
+  CHECK(frame.time == expected.time);
+  CHECK_EQ(frame.total_processes, expected.total_processes);
+  CHECK_EQ(frame.started, expected.started);
+  CHECK_EQ(frame.exited, expected.exited);
+  CHECK_EQ(frame.uptime, expected.uptime);
+  CHECK_EQ(frame.rows.size(), expected.rows.size());
+  for (std::size_t i = 0; i < frame.rows.size() && i < expected.rows.size();
+       ++i) {
+    const Frame::Row& row = frame.rows[i];
+    const Expected::Row& want = expected.rows[i];
+    CHECK_EQ(row.pid, want.pid);
+    CHECK_EQ(string(row.user), want.user);
+    CHECK_EQ(row.command, want.command);
+    CHECK_EQ(std::lround(row.cpu * 10000), want.cpu);
+    CHECK_EQ(row.ram, want.ram);
+    CHECK_EQ(row.uptime, want.uptime);
+  }
+}
+
+// Size of the newest file of a log.
+static std::uintmax_t NewestSize(const string& directory) {
+  fs::path newest;
+  for (const auto& entry : fs::directory_iterator(directory)) {
+    newest = std::max(newest, entry.path());
+  }
+  return fs::file_size(newest);
+}
+
+// Ticks written with rotation, keyframes, processes coming and going,
+// pids far apart and CPU going down as well as up read back as written,
+// in order and out of it. A write cut short by RLIMIT_FSIZE fails, and
+// the writer goes on in a fresh file.
+static void RoundTrip() {
+  TestRoot root("metrics_log_test");
+  string directory = root.Root() + "/log";
+  fs::create_directories(directory);
+  const int pids[] = {1, 2, 300, 70000, 4000000};
+  const int kTicks{150};
+  const int kCut{100};  // tick whose write fails
+  auto usage = [](int pid, int tick) -> long {
+    return (long)tick * (pid % 7) * 3 + (tick % 5) * (tick % 3) * 7;
+  };
+  long start = root.UptimeTicks() - 5000;
+  for (int pid : pids) {
+    root.Set(pid, 0, start);
+  }
+  root.Tick();
+  LinuxParser::SetRoot(root.Root());
+
+  System system(1);
+  MetricsLog::Writer writer(directory, 4096);
+  vector<Expected> written;
+  auto time = std::chrono::system_clock::time_point(
+      std::chrono::milliseconds(1700000000123));
+  for (int tick = 0; tick < kTicks; ++tick) {
+    if (tick > 0) {
+      for (int pid : pids) {
+        if (pid == 300 && tick >= 40 && tick < 90) {
+          root.Remove(pid);
+        } else {
+          root.Set(pid, usage(pid, tick), pid == 300 && tick >= 90
+                                              ? start + 100 * tick
+                                              : start);
+        }
+      }
+      root.Tick();
+      system.Refresh();
+    }
+    const vector<Process>& processes = system.Processes();
+    Expected expected = Take(time, system);
+    if (tick == kCut) {
+      rlimit limit{NewestSize(directory) + 8, RLIM_INFINITY};
+      rlimit unlimited{RLIM_INFINITY, RLIM_INFINITY};
+      signal(SIGXFSZ, SIG_IGN);
+      setrlimit(RLIMIT_FSIZE, &limit);
+      CHECK(!writer.Write(time, system, processes));
+      setrlimit(RLIMIT_FSIZE, &unlimited);
+    } else {
+      CHECK(writer.Write(time, system, processes));
+      written.push_back(expected);
+    }
+    time += std::chrono::milliseconds(1000 + tick % 4);
+  }
+  LinuxParser::SetRoot("");
+
+  std::size_t files = std::distance(fs::directory_iterator(directory),
+                                    fs::directory_iterator());
+  CHECK(files >= 3);
+  MetricsLog::Reader reader(directory);
+  CHECK_EQ(reader.Ticks(), written.size());
+  if (reader.Ticks() != written.size()) {
+    return;
+  }
+  for (std::size_t tick = 0; tick < written.size(); ++tick) {
+    Compare(reader, tick, written[tick]);
+  }
+  for (std::size_t tick = written.size(); tick-- > 0;) {
+    Compare(reader, tick, written[tick]);
+  }
+}
+
+int main() {
+  RoundTrip();
+  return Failures() != 0;
+}
@@ -0,0 +1,191 @@
+#include <unistd.h>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "linux_parser.h"
+#include "process_table.h"
+#include "system_snapshot.h"
+#include "test_root.h"
+
+using std::string;
+using std::uint32_t;
+
+static string PidFile(const TestRoot& root, int pid, const string& name) {
+  return root.Root() + LinuxParser::kProcDirectory + std::to_string(pid) +
+         name;
+}
+
+static void SetStatus(const TestRoot& root, int pid, int uid, long rss) {
+  std::ofstream(PidFile(root, pid, LinuxParser::kStatusFilename))
+      << "Name:\ttask" << pid << "\nUid:\t" << uid << "\t" << uid << "\t"
+      << uid << "\t" << uid << "\nVmRSS:\t" << rss << " kB\n";
+}
+
+static void SetIo(const TestRoot& root, int pid, long read, long write) {
+  std::ofstream(PidFile(root, pid, LinuxParser::kIoFilename))
+      << "rchar: 0\nwchar: 0\nread_bytes: " << read
+      << "\nwrite_bytes: " << write << "\n";
+}
+
+static void SetCommand(const TestRoot& root, int pid, const string& text) {
+  std::ofstream(PidFile(root, pid, LinuxParser::kCmdlineFilename))
+      << text << '\0';
+}
+
+// The pids of the first count rows by column.
+static std::vector<int> Ranked(ProcessTable& table,
+                               ProcessTable::Column column, size_t count,
+                               long tick) {
+  std::vector<uint32_t> rows;
+  table.Rank(column, count, tick, rows);
+  std::vector<int> pids;
+  for (uint32_t row : rows) {
+    pids.push_back(table.Pid(row));
+  }
+  return pids;
+}
+
+// Five processes, inserted out of pid order, whose values tie in pairs
+// on every column: ties must come by pid, not by row. Pid 40 has no
+// status, so its user is unknown and comes last, and no io, so it has
+// no I/O rate and comes last there too.
+static void RanksEveryColumn() {
+  const int pids[] = {30, 10, 50, 20, 40};
+  const long busy[] = {200, 100, 200, 0, 100};  // ticks of the second
+  const long cpu_time[] = {5, 7, 7, 1, 5};      // seconds
+  const int uids[] = {1000, 1001, 0, 1001, -1};
+  const long rss[] = {3000, 1000, 3000, 5000, 0};
+  const long read[] = {4000, 1000, 3000, 2000, 0};
+  const long written[] = {0, 5000, 0, 1000, 0};
+  const int n = 5;
+
+  TestRoot root("process_table_test");
+  for (int i = 0; i < n; ++i) {
+    root.Set(pids[i], 0, 100);
+  }
+  root.Tick();
+  std::ofstream(root.Root() + LinuxParser::kPasswordPath)
+      << "root:x:0:0:root:/root:/bin/sh\n"
+      << "zed:x:1000:1000::/home/zed:/bin/sh\n"
+      << "alice:x:1001:1001::/home/alice:/bin/sh\n";
+  for (int i = 0; i < n; ++i) {
+    if (uids[i] >= 0) {
+      SetStatus(root, pids[i], uids[i], rss[i]);
+    } else {
+      std::remove(PidFile(root, pids[i], LinuxParser::kStatusFilename).c_str());
+    }
+    if (i < n - 1) {
+      SetIo(root, pids[i], 0, 0);
+    }
+  }
+  LinuxParser::SetRoot(root.Root());
+
+  // Two ticks, 1000 machine jiffies apart, so CPU shares are busy/1000.
+  ProcessTable table;
+  SystemSnapshot snapshot;
+  long hertz = sysconf(_SC_CLK_TCK);
+  for (long tick = 1; tick <= 2; ++tick) {
+    snapshot.cpu.times[0] = tick * 1000;
+    for (int i = 0; i < n; ++i) {
+      LinuxParser::ProcessStat stat;
+      stat.state = 'S';
+      stat.utime = tick == 1 ? 0 : busy[i];
+      stat.cutime = cpu_time[i] * hertz - stat.utime;
+      stat.starttime = 100;
+      uint32_t row = tick == 1 ? table.Insert(pids[i], stat.starttime)
+                               : table.Find(pids[i]);
+      table.Update(row, stat, snapshot, tick);
+    }
+  }
+
+  CHECK(Ranked(table, ProcessTable::kPid, n, 2) ==
+        (std::vector<int>{10, 20, 30, 40, 50}));
+  CHECK(Ranked(table, ProcessTable::kCpu, n, 2) ==
+        (std::vector<int>{30, 50, 10, 40, 20}));
+  CHECK(Ranked(table, ProcessTable::kUpTime, n, 2) ==
+        (std::vector<int>{10, 50, 30, 40, 20}));
+  CHECK(Ranked(table, ProcessTable::kRam, n, 2) ==
+        (std::vector<int>{20, 30, 50, 10, 40}));
+  // alice, root, zed, then the unknown uid.
+  CHECK(Ranked(table, ProcessTable::kUser, n, 2) ==
+        (std::vector<int>{10, 20, 50, 30, 40}));
+  // A first read of io has nothing to compare against: all tie at 0.
+  CHECK(Ranked(table, ProcessTable::kRead, n, 2) ==
+        (std::vector<int>{10, 20, 30, 50, 40}));
+
+  // The next tick reads io again, now with bytes moved since.
+  for (int i = 0; i < n - 1; ++i) {
+    SetIo(root, pids[i], read[i], written[i]);
+  }
+  usleep(10000);
+  snapshot.cpu.times[0] = 3000;
+  for (int i = 0; i < n; ++i) {
+    LinuxParser::ProcessStat stat;
+    stat.state = 'S';
+    stat.starttime = 100;
+    table.Update(table.Find(pids[i]), stat, snapshot, 3);
+  }
+  CHECK(Ranked(table, ProcessTable::kRead, n, 3) ==
+        (std::vector<int>{30, 50, 20, 10, 40}));
+  CHECK(Ranked(table, ProcessTable::kWrite, n, 3) ==
+        (std::vector<int>{10, 20, 30, 50, 40}));
+
+  // Fewer than all rows, and more than there are.
+  CHECK(Ranked(table, ProcessTable::kPid, 2, 3) ==
+        (std::vector<int>{10, 20}));
+  CHECK(Ranked(table, ProcessTable::kPid, 100, 3) ==
+        (std::vector<int>{10, 20, 30, 40, 50}));
+  // Rows not seen this tick are not ranked.
+  CHECK(Ranked(table, ProcessTable::kPid, 100, 4).empty());
+
+  // Ties still go by pid once Erase() has moved the last row.
+  table.Erase(30);
+  CHECK(Ranked(table, ProcessTable::kWrite, n, 3) ==
+        (std::vector<int>{10, 20, 50, 40}));
+  LinuxParser::SetRoot("");
+}
+
+// A command is kept while any row uses it and its slot goes to the next
+// new command once the last of them is erased.
+static void FreesUnusedCommands() {
+  TestRoot root("process_table_test");
+  for (int pid = 1; pid <= 5; ++pid) {
+    root.Set(pid, 0, 100);
+  }
+  root.Tick();
+  SetCommand(root, 1, "/bin/sh");
+  SetCommand(root, 2, "/bin/sh");
+  LinuxParser::SetRoot(root.Root());
+
+  ProcessTable table;
+  table.Insert(1, 100);
+  table.Insert(2, 100);
+  const string* shell = &table.Command(table.Find(1));
+  CHECK_EQ(*shell, "/bin/sh");
+  CHECK(&table.Command(table.Find(2)) == shell);
+
+  // Pid 2 still uses it.
+  table.Erase(1);
+  CHECK(&table.Command(table.Find(2)) == shell);
+  table.Insert(3, 100);
+  CHECK(&table.Command(table.Find(3)) != shell);
+  CHECK_EQ(*shell, "/bin/sh");
+
+  // Nobody does now: the next new command takes its place.
+  table.Erase(2);
+  table.Insert(4, 100);
+  CHECK(&table.Command(table.Find(4)) == shell);
+  CHECK_EQ(*shell, "/usr/bin/task4");
+  CHECK_EQ(table.Command(table.Find(3)), "/usr/bin/task3");
+  LinuxParser::SetRoot("");
+}
+
+int main() {
+  RanksEveryColumn();
+  FreesUnusedCommands();
+  return Failures() != 0;
+}
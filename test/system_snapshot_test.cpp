@@ -0,0 +1,39 @@
+#include <fstream>
+#include <string>
+
+#include "check.h"
+#include "linux_parser.h"
+#include "system_snapshot.h"
+#include "test_root.h"
+
+// Partitions are left out of the disks and whole devices kept, also
+// when one device's name starts with another's: nvme0n10 is a disk of
+// its own, not partition 0 of nvme0n1.
+static void KeepsWholeDisks() {
+  TestRoot root("system_snapshot_test");
+  std::ofstream(root.Root() + LinuxParser::kProcDirectory +
+                LinuxParser::kDiskstatsFilename)
+      << "   8  0 sda 10 0 80 5 20 0 160 7 0 12 12\n"
+      << "   8  1 sda1 9 0 72 4 20 0 160 7 0 11 11\n"
+      << " 259  0 nvme0n1 10 0 80 5 20 0 160 7 0 12 12\n"
+      << " 259  1 nvme0n1p1 9 0 72 4 20 0 160 7 0 11 11\n"
+      << " 259  2 nvme0n10 10 0 80 5 20 0 160 7 0 12 12\n"
+      << " 179  0 mmcblk0 10 0 80 5 20 0 160 7 0 12 12\n"
+      << " 179  2 mmcblk0p2 9 0 72 4 20 0 160 7 0 11 11\n"
+      << "   7  0 loop0 10 0 80 5 0 0 0 0 0 5 5\n";
+  LinuxParser::SetRoot(root.Root());
+  SystemSnapshot snapshot;
+  snapshot.Refresh();
+  LinuxParser::SetRoot("");
+
+  const char* whole[] = {"sda", "nvme0n1", "nvme0n10", "mmcblk0"};
+  CHECK_EQ(snapshot.disks.size(), sizeof(whole) / sizeof(whole[0]));
+  for (size_t i = 0; i < snapshot.disks.size() && i < 4; ++i) {
+    CHECK_EQ(std::string(snapshot.disks[i].name), whole[i]);
+  }
+}
+
+int main() {
+  KeepsWholeDisks();
+  return Failures() != 0;
+}
@@ -0,0 +1,119 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "linux_parser.h"
+#include "test_root.h"
+
+namespace fs = std::filesystem;
+using std::string;
+using std::string_view;
+
+// Seconds the machine was up before the first tick, and clock ticks per
+// second.
+static const long kUptime{10000};
+static const long kHertz{100};
+
+static void Write(const string& path, string_view text) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return;
+  }
+  while (!text.empty()) {
+    ssize_t written = write(fd, text.data(), text.size());
+    if (written <= 0) {
+      break;
+    }
+    text.remove_prefix(written);
+  }
+  close(fd);
+}
+
+TestRoot::TestRoot(const string& name, int cores)
+    : root_((fs::temp_directory_path() /
+             (name + "." + std::to_string(getpid())))
+                .string()),
+      cores_(cores) {
+  using namespace LinuxParser;
+  fs::create_directories(root_ + kProcDirectory);
+  fs::create_directories(fs::path(root_ + kOSPath).parent_path());
+  ::Write(root_ + kOSPath, "PRETTY_NAME=\"Test Linux\"\n");
+  ::Write(root_ + kPasswordPath, "root:x:0:0:root:/root:/bin/sh\n");
+  ::Write(root_ + kProcDirectory + kVersionFilename,
+          "Linux version 6.1.0-test (test@test) #1 SMP\n");
+  Write();
+}
+
+TestRoot::~TestRoot() {
+  std::error_code error;
+  fs::remove_all(root_, error);
+}
+
+// Add pid, or give it a new total of CPU time in clock ticks.
+void TestRoot::Set(int pid, long utime, long starttime) {
+  tasks_[pid] = {utime, starttime};
+}
+
+void TestRoot::Remove(int pid) {
+  tasks_.erase(pid);
+  std::error_code error;
+  fs::remove_all(root_ + LinuxParser::kProcDirectory + std::to_string(pid),
+                 error);
+}
+
+// A second later; every core was busy half of it.
+void TestRoot::Tick() {
+  ++tick_;
+  Write();
+}
+
+const string& TestRoot::Root() const { return root_; }
+
+long TestRoot::UptimeTicks() const { return (kUptime + tick_) * kHertz; }
+
+void TestRoot::Write() const {
+  using namespace LinuxParser;
+  const string proc = root_ + kProcDirectory;
+  long half = UptimeTicks() / 2;
+  char line[512];
+  string stat;
+  for (int core = -1; core < cores_; ++core) {
+    long share = core < 0 ? half * cores_ : half;
+    string name = core < 0 ? "cpu " : "cpu" + std::to_string(core);
+    snprintf(line, sizeof(line), "%s %ld 0 0 %ld 0 0 0 0 0 0\n",
+             name.c_str(), share, share);
+    stat += line;
+  }
+  snprintf(line, sizeof(line), "processes %zu\nprocs_running 1\n",
+           tasks_.size());
+  stat += line;
+  ::Write(proc + kStatFilename, stat);
+  ::Write(proc + kMeminfoFilename,
+          "MemTotal:        8000000 kB\nMemFree:         4000000 kB\n");
+  snprintf(line, sizeof(line), "%ld.00 %ld.00\n", UptimeTicks() / kHertz,
+           half / kHertz);
+  ::Write(proc + kUptimeFilename, line);
+
+  for (const auto& [pid, task] : tasks_) {
+    string directory = proc + std::to_string(pid);
+    fs::create_directories(directory);
+    snprintf(line, sizeof(line),
+             "%d (task%d) S 1 %d %d 0 -1 4194560 100 0 0 0 %ld 0 0 0 20 0 1 "
+             "0 %ld 10000000 500 18446744073709551615 1 1 0 0 0 0 0 4096 "
+             "16387 0 0 0 17 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+             pid, pid, pid, pid, task.utime, task.starttime);
+    ::Write(directory + kStatFilename, line);
+    snprintf(line, sizeof(line),
+             "Name:\ttask%d\nState:\tS (sleeping)\nPid:\t%d\nPPid:\t1\n"
+             "Uid:\t0\t0\t0\t0\nVmSize:\t   10000 kB\nVmRSS:\t    2000 kB\n"
+             "Threads:\t1\n",
+             pid, pid);
+    ::Write(directory + kStatusFilename, line);
+    snprintf(line, sizeof(line), "/usr/bin/task%d", pid);
+    ::Write(directory + kCmdlineFilename, string_view(line, strlen(line) + 1));
+  }
+}
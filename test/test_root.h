@@ -0,0 +1,43 @@
+#ifndef TEST_ROOT_H
+#define TEST_ROOT_H
+
+#include <map>
+#include <string>
+
+/*
+ * TestRoot class
+ * A small root for LinuxParser::SetRoot() whose processes a test
+ * controls exactly: proc/{stat,meminfo,uptime,version},
+ * etc/{os-release,passwd} and proc/<pid>/{stat,status,cmdline}.
+ * Set() adds a process or changes its CPU time, Remove() ends it and
+ * Tick() moves the clock on by a second and writes everything out.
+ * The tree is removed on destruction.
+ */
+class TestRoot {
+ public:
+  explicit TestRoot(const std::string& name, int cores = 4);
+  ~TestRoot();
+  TestRoot(const TestRoot&) = delete;
+  TestRoot& operator=(const TestRoot&) = delete;
+
+  void Set(int pid, long utime, long starttime);
+  void Remove(int pid);
+  void Tick();
+  const std::string& Root() const;
+  long UptimeTicks() const;  // clock ticks, as process start times
+
+ private:
+  struct Task {
+    long utime{0};
+    long starttime{0};
+  };
+
+  void Write() const;
+
+  std::string root_;
+  int cores_;
+  long tick_{0};
+  std::map<int, Task> tasks_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "triple_buffer.h"
+
+// A frame is whole when every value is its number and it has the size
+// that number gives it.
+static std::size_t FrameSize(long number) { return 1 + number % 61; }
+
+static bool Whole(const std::vector<long>& frame) {
+  if (frame.empty()) {
+    return false;
+  }
+  for (long value : frame) {
+    if (value != frame[0]) {
+      return false;
+    }
+  }
+  return frame.size() == FrameSize(frame[0]);
+}
+
+static void Fill(std::vector<long>& frame, long number) {
+  frame.assign(FrameSize(number), number);
+}
+
+// The reader gets the latest frame, and with nothing new it keeps the
+// one it has.
+static void KeepsLatest() {
+  TripleBuffer<std::vector<long>> buffer;
+  CHECK(!buffer.Update());
+  Fill(buffer.Back(), 1);
+  buffer.Publish();
+  CHECK(buffer.Update());
+  CHECK_EQ(buffer.Front()[0], 1);
+  CHECK(!buffer.Update());
+  CHECK_EQ(buffer.Front()[0], 1);
+
+  // Frames the reader missed are skipped.
+  for (long number = 2; number <= 4; ++number) {
+    Fill(buffer.Back(), number);
+    buffer.Publish();
+  }
+  CHECK(buffer.Update());
+  CHECK(Whole(buffer.Front()));
+  CHECK_EQ(buffer.Front()[0], 4);
+  CHECK(!buffer.Update());
+  CHECK_EQ(buffer.Front()[0], 4);
+}
+
+// One thread publishes numbered frames as fast as it can while another
+// reads them: every frame read is whole, each is newer than the one
+// before, a read with nothing new keeps the last frame, and the last
+// frame published arrives.
+static void HandsOverBetweenThreads() {
+  const long kFrames{200000};
+  TripleBuffer<std::vector<long>> buffer;
+  std::thread writer([&buffer]() {
+    for (long number = 1; number <= kFrames; ++number) {
+      Fill(buffer.Back(), number);
+      buffer.Publish();
+    }
+  });
+
+  long last{0};
+  long torn{0};
+  long older{0};
+  long changed{0};
+  long updates{0};
+  while (last < kFrames) {
+    if (buffer.Update()) {
+      ++updates;
+      const std::vector<long>& frame = buffer.Front();
+      if (!Whole(frame)) {
+        ++torn;
+        break;
+      }
+      if (frame[0] <= last) {
+        ++older;
+      }
+      last = frame[0];
+    } else if (last > 0 && (!Whole(buffer.Front()) ||
+                            buffer.Front()[0] != last)) {
+      ++changed;
+    }
+  }
+  writer.join();
+  CHECK_EQ(torn, 0);
+  CHECK_EQ(older, 0);
+  CHECK_EQ(changed, 0);
+  CHECK(updates > 0);
+  CHECK(!buffer.Update());
+  CHECK_EQ(buffer.Front()[0], kFrames);
+}
+
+int main() {
+  KeepsLatest();
+  HandsOverBetweenThreads();
+  return Failures() != 0;
+}
@@ -0,0 +1,39 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+
+#include "check.h"
+#include "user_cache.h"
+
+// Names come from the password file; a uid field that is not a number
+// must not make its user root, and the first of two lines wins.
+static void ReadsPasswordFile() {
+  char path[] = "/tmp/user_cache_test.XXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  close(fd);
+  std::ofstream(path) << "broken:x:abc:0::/:/bin/false\n"
+                      << "empty:x::0::/:/bin/false\n"
+                      << "root:x:0:0:root:/root:/bin/bash\n"
+                      << "alice:x:1000:1000::/home/alice:/bin/sh\n"
+                      << "again:x:1000:1000::/home/again:/bin/sh\n"
+                      << "bob:x:1001:1001::/home/bob:/bin/sh\n";
+  UserCache users(path);
+  CHECK_EQ(users.Name(0), "root");
+  CHECK_EQ(users.Name(1000), "alice");
+  CHECK_EQ(users.Name(1001), "bob");
+
+  // A name outlives the reload that replaces it.
+  std::string name = users.Name(1001);
+  std::ofstream(path) << "carol:x:1001:1001::/home/carol:/bin/sh\n";
+  users.SetPath(path);
+  CHECK_EQ(name, "bob");
+  CHECK_EQ(users.Name(1001), "carol");
+  unlink(path);
+}
+
+int main() {
+  ReadsPasswordFile();
+  return Failures() != 0;
+}